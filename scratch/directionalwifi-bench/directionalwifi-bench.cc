@@ -0,0 +1,601 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Scalability benchmark of the directional wifi model.
+ *
+ * Builds an ad hoc network of --nodes nodes laid out on a grid, uniformly
+ * at random or in clusters (--topology), with switched-beam or isotropic
+ * antennas (--antenna). Every node sends single-hop unicast frames to its
+ * nearest neighbour, either back to back at the data rate (saturated) or
+ * as a Poisson process of --rate frames per second (--traffic). The
+ * network is simulated for --duration seconds and one JSON object is
+ * written to --output (stdout by default) with the wall clock time of
+ * each phase, the number of simulator events, events per second,
+ * simulated seconds per wall clock second, the peak resident set size
+ * and frame counters.
+ *
+ * With --profile, the simulator runs on a scheduler which also charges
+ * the wall clock time between two events to the class of the first one,
+ * and the JSON object gets a per-module (channel, phy, mac, other)
+ * breakdown and the most expensive event types.
+ *
+ * Attributes of the model can be set on the command line as usual, e.g.
+ * --ns3::YansWifiChannel::SpatialIndex=true. A scaling sweep is one
+ * process per point, so that the peak RSS of each point is its own:
+ *
+ *   for n in 10 100 1000 10000; do
+ *     ./waf --run "directionalwifi-bench --nodes=$n --topology=random" >> bench.jsonl
+ *   done
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <typeinfo>
+#include <cxxabi.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/wifiantenna-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DirectionalWifiBench");
+
+static const uint16_t BENCH_PROTOCOL = 0x88b5; // IEEE local experimental ethertype
+
+static double
+MonotonicSeconds (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Map scheduler which counts the events it hands out and, when
+ * profiling, charges the wall clock time until the next RemoveNext to
+ * the type of the event just removed: the simulator invokes an event
+ * right after removing it and removes the next one right after that.
+ */
+class BenchScheduler : public MapScheduler
+{
+public:
+  static TypeId GetTypeId (void);
+  BenchScheduler ();
+
+  virtual Event RemoveNext (void);
+
+  static uint64_t GetEvents (void);
+  static uint64_t GetCancelledEvents (void);
+  static void SetProfiling (bool profile);
+  /**
+   * Charge the time of the event running now and stop profiling.
+   */
+  static void Flush (void);
+  typedef std::map<const std::type_info *, std::pair<uint64_t, double> > Profile;
+  static const Profile & GetProfile (void);
+
+private:
+  static uint64_t g_events;
+  static uint64_t g_cancelled;
+  static bool g_profile;
+  static const std::type_info *g_current;
+  static double g_currentStart;
+  static Profile g_byType;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (BenchScheduler);
+
+uint64_t BenchScheduler::g_events = 0;
+uint64_t BenchScheduler::g_cancelled = 0;
+bool BenchScheduler::g_profile = false;
+const std::type_info *BenchScheduler::g_current = 0;
+double BenchScheduler::g_currentStart = 0;
+BenchScheduler::Profile BenchScheduler::g_byType;
+
+TypeId
+BenchScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BenchScheduler")
+    .SetParent<MapScheduler> ()
+    .AddConstructor<BenchScheduler> ()
+  ;
+  return tid;
+}
+
+BenchScheduler::BenchScheduler ()
+{
+}
+
+Scheduler::Event
+BenchScheduler::RemoveNext (void)
+{
+  Event ev = MapScheduler::RemoveNext ();
+  g_events++;
+  if (ev.impl->IsCancelled ())
+    {
+      g_cancelled++;
+    }
+  if (g_profile)
+    {
+      double now = MonotonicSeconds ();
+      if (g_current != 0)
+        {
+          std::pair<uint64_t, double> &slot = g_byType[g_current];
+          slot.first++;
+          slot.second += now - g_currentStart;
+        }
+      g_current = &typeid (*ev.impl);
+      g_currentStart = now;
+    }
+  return ev;
+}
+
+uint64_t
+BenchScheduler::GetEvents (void)
+{
+  return g_events;
+}
+
+uint64_t
+BenchScheduler::GetCancelledEvents (void)
+{
+  return g_cancelled;
+}
+
+void
+BenchScheduler::SetProfiling (bool profile)
+{
+  g_profile = profile;
+}
+
+void
+BenchScheduler::Flush (void)
+{
+  if (g_profile && g_current != 0)
+    {
+      std::pair<uint64_t, double> &slot = g_byType[g_current];
+      slot.first++;
+      slot.second += MonotonicSeconds () - g_currentStart;
+    }
+  g_current = 0;
+  g_profile = false;
+}
+
+const BenchScheduler::Profile &
+BenchScheduler::GetProfile (void)
+{
+  return g_byType;
+}
+
+static std::string
+Demangle (const std::type_info *type)
+{
+  int status = 0;
+  char *name = abi::__cxa_demangle (type->name (), 0, 0, &status);
+  if (name == 0)
+    {
+      return type->name ();
+    }
+  std::string retval (name);
+  std::free (name);
+  return retval;
+}
+
+/**
+ * \return the class whose member function the event invokes, or
+ * an empty string for events bound to a free function
+ */
+static std::string
+EventClass (const std::string &eventType)
+{
+  std::string::size_type end = eventType.find ("::*)");
+  if (end == std::string::npos)
+    {
+      return "";
+    }
+  std::string::size_type start = eventType.rfind ('(', end);
+  std::string cls = eventType.substr (start + 1, end - start - 1);
+  if (cls.compare (0, 5, "ns3::") == 0)
+    {
+      cls = cls.substr (5);
+    }
+  return cls;
+}
+
+static std::string
+EventModule (const std::string &cls)
+{
+  static const char *channel[] = { "YansWifiChannel", 0 };
+  static const char *phy[] = { "YansWifiPhy", "WifiPhy", "WifiPhyStateHelper",
+                               "InterferenceHelper", 0 };
+  static const char *mac[] = { "MacLow", "DcfManager", "DcaTxop", "EdcaTxopN",
+                               "WifiLazyTimer", "MacRxMiddle", "MacTxMiddle",
+                               "RegularWifiMac", "AdhocWifiMac",
+                               "WifiRemoteStationManager", "WifiNetDevice", 0 };
+  static const char **modules[] = { channel, phy, mac };
+  static const char *names[] = { "channel", "phy", "mac" };
+  for (uint32_t m = 0; m < 3; m++)
+    {
+      for (const char **c = modules[m]; *c != 0; c++)
+        {
+          if (cls == *c)
+            {
+              return names[m];
+            }
+        }
+    }
+  return "other";
+}
+
+static std::string
+JsonString (const std::string &s)
+{
+  std::ostringstream os;
+  os << '"';
+  for (std::string::const_iterator i = s.begin (); i != s.end (); i++)
+    {
+      if (*i == '"' || *i == '\\')
+        {
+          os << '\\';
+        }
+      os << *i;
+    }
+  os << '"';
+  return os.str ();
+}
+
+struct Counters
+{
+  Counters ()
+    : generated (0), txBegin (0), rxEnd (0), rxDrop (0), delivered (0)
+  {
+  }
+  uint64_t generated;
+  uint64_t txBegin;
+  uint64_t rxEnd;
+  uint64_t rxDrop;
+  uint64_t delivered;
+};
+
+static Counters g_counters;
+
+static void
+CountTxBegin (Ptr<const Packet> packet)
+{
+  g_counters.txBegin++;
+}
+
+static void
+CountRxEnd (Ptr<const Packet> packet)
+{
+  g_counters.rxEnd++;
+}
+
+static void
+CountRxDrop (Ptr<const Packet> packet)
+{
+  g_counters.rxDrop++;
+}
+
+static bool
+CountDelivered (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                const Address &from)
+{
+  g_counters.delivered++;
+  return true;
+}
+
+static std::vector<Vector>
+CreateTopology (const std::string &topology, uint32_t nodes, double spacing,
+                uint32_t clusterSize)
+{
+  std::vector<Vector> positions;
+  // the random and clustered layouts cover the area of the grid
+  double side = spacing * std::ceil (std::sqrt (static_cast<double> (nodes)));
+  if (topology == "grid")
+    {
+      uint32_t columns = static_cast<uint32_t> (std::ceil (std::sqrt (static_cast<double> (nodes))));
+      for (uint32_t i = 0; i < nodes; i++)
+        {
+          positions.push_back (Vector (spacing * (i % columns), spacing * (i / columns), 0));
+        }
+    }
+  else if (topology == "random")
+    {
+      Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+      u->SetAttribute ("Max", DoubleValue (side));
+      for (uint32_t i = 0; i < nodes; i++)
+        {
+          positions.push_back (Vector (u->GetValue (), u->GetValue (), 0));
+        }
+    }
+  else if (topology == "clustered")
+    {
+      Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+      u->SetAttribute ("Max", DoubleValue (side));
+      Ptr<NormalRandomVariable> n = CreateObject<NormalRandomVariable> ();
+      n->SetAttribute ("Variance", DoubleValue (spacing * spacing));
+      uint32_t clusters = std::max<uint32_t> (1, nodes / clusterSize);
+      std::vector<Vector> centers;
+      for (uint32_t c = 0; c < clusters; c++)
+        {
+          centers.push_back (Vector (u->GetValue (), u->GetValue (), 0));
+        }
+      for (uint32_t i = 0; i < nodes; i++)
+        {
+          const Vector &center = centers[i % clusters];
+          positions.push_back (Vector (center.x + n->GetValue (), center.y + n->GetValue (), 0));
+        }
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown topology " << topology);
+    }
+  return positions;
+}
+
+/**
+ * \return for each node, the index of the closest other node
+ */
+static std::vector<uint32_t>
+NearestNeighbours (const std::vector<Vector> &positions)
+{
+  std::vector<uint32_t> nearest (positions.size (), 0);
+  for (uint32_t i = 0; i < positions.size (); i++)
+    {
+      double best = -1;
+      for (uint32_t j = 0; j < positions.size (); j++)
+        {
+          if (i == j)
+            {
+              continue;
+            }
+          double dx = positions[i].x - positions[j].x;
+          double dy = positions[i].y - positions[j].y;
+          double d = dx * dx + dy * dy;
+          if (best < 0 || d < best)
+            {
+              best = d;
+              nearest[i] = j;
+            }
+        }
+    }
+  return nearest;
+}
+
+/**
+ * Send one frame to dest and schedule the next one after a draw of
+ * interval.
+ */
+static void
+SendFrame (Ptr<NetDevice> device, Mac48Address dest, uint32_t size,
+           Ptr<RandomVariableStream> interval)
+{
+  device->Send (Create<Packet> (size), dest, BENCH_PROTOCOL);
+  g_counters.generated++;
+  Simulator::Schedule (Seconds (interval->GetValue ()), &SendFrame, device, dest, size, interval);
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodes = 100;
+  std::string topology = "grid";
+  std::string traffic = "saturated";
+  std::string antenna = "switched";
+  double spacing = 50.0;
+  uint32_t clusterSize = 20;
+  double rate = 10.0;
+  uint32_t packetSize = 1000;
+  double duration = 10.0;
+  uint32_t seed = 1;
+  uint32_t run = 1;
+  bool profile = false;
+  uint32_t topEvents = 10;
+  std::string output = "-";
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Number of nodes", nodes);
+  cmd.AddValue ("topology", "Layout of the nodes: grid, random or clustered", topology);
+  cmd.AddValue ("traffic", "Offered load: saturated or poisson", traffic);
+  cmd.AddValue ("antenna", "Antenna of every node: switched or isotropic", antenna);
+  cmd.AddValue ("spacing", "Grid step (m); also the cluster spread of the clustered layout", spacing);
+  cmd.AddValue ("clusterSize", "Average number of nodes per cluster", clusterSize);
+  cmd.AddValue ("rate", "Frames per second per node of the poisson traffic", rate);
+  cmd.AddValue ("packetSize", "Payload of every frame (bytes)", packetSize);
+  cmd.AddValue ("duration", "Simulated time (s)", duration);
+  cmd.AddValue ("seed", "Seed of the random number generator", seed);
+  cmd.AddValue ("run", "Run number of the random number generator", run);
+  cmd.AddValue ("profile", "Break the run time down by module and event type", profile);
+  cmd.AddValue ("top", "Number of event types listed when profiling", topEvents);
+  cmd.AddValue ("output", "File the JSON result is appended to, - for stdout", output);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (nodes < 2, "At least two nodes are needed");
+  NS_ABORT_MSG_IF (traffic != "saturated" && traffic != "poisson", "Unknown traffic " << traffic);
+  NS_ABORT_MSG_IF (antenna != "switched" && antenna != "isotropic", "Unknown antenna " << antenna);
+
+  RngSeedManager::SetSeed (seed);
+  RngSeedManager::SetRun (run);
+  GlobalValue::Bind ("SchedulerType", StringValue ("ns3::BenchScheduler"));
+
+  double setupStart = MonotonicSeconds ();
+
+  NodeContainer c;
+  c.Create (nodes);
+
+  WifiHelper wifi = WifiHelper::Default ();
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("OfdmRate6Mbps"),
+                                "ControlMode", StringValue ("OfdmRate6Mbps"));
+  NqosWifiMacHelper wifiMac = NqosWifiMacHelper::Default ();
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default ();
+  wifiPhy.SetChannel (wifiChannel.Create ());
+  if (antenna == "isotropic")
+    {
+      wifiPhy.SetAntenna ("ns3::WifiIsotropicAntennaModel");
+    }
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  std::vector<Vector> positions = CreateTopology (topology, nodes, spacing, clusterSize);
+  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      positionAlloc->Add (positions[i]);
+    }
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator (positionAlloc);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  // back to back frames at the data rate keep every queue full
+  double airtime = packetSize * 8 / 6e6;
+  std::vector<uint32_t> nearest = NearestNeighbours (positions);
+  Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable> ();
+  jitter->SetAttribute ("Max", DoubleValue (airtime));
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      Ptr<NetDevice> device = devices.Get (i);
+      Ptr<WifiPhy> phy = DynamicCast<WifiNetDevice> (device)->GetPhy ();
+      phy->TraceConnectWithoutContext ("PhyTxBegin", MakeCallback (&CountTxBegin));
+      phy->TraceConnectWithoutContext ("PhyRxEnd", MakeCallback (&CountRxEnd));
+      phy->TraceConnectWithoutContext ("PhyRxDrop", MakeCallback (&CountRxDrop));
+      device->SetReceiveCallback (MakeCallback (&CountDelivered));
+
+      Ptr<RandomVariableStream> interval;
+      if (traffic == "saturated")
+        {
+          interval = CreateObject<ConstantRandomVariable> ();
+          interval->SetAttribute ("Constant", DoubleValue (airtime));
+        }
+      else
+        {
+          interval = CreateObject<ExponentialRandomVariable> ();
+          interval->SetAttribute ("Mean", DoubleValue (1.0 / rate));
+        }
+      Mac48Address dest = Mac48Address::ConvertFrom (devices.Get (nearest[i])->GetAddress ());
+      Simulator::ScheduleWithContext (i, Seconds (jitter->GetValue ()), &SendFrame,
+                                      device, dest, packetSize, interval);
+    }
+  Simulator::Stop (Seconds (duration));
+
+  double runStart = MonotonicSeconds ();
+  BenchScheduler::SetProfiling (profile);
+  Simulator::Run ();
+  BenchScheduler::Flush ();
+  double runEnd = MonotonicSeconds ();
+  uint64_t events = BenchScheduler::GetEvents ();
+  uint64_t cancelled = BenchScheduler::GetCancelledEvents ();
+  Simulator::Destroy ();
+  double destroyEnd = MonotonicSeconds ();
+
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+
+  double runTime = runEnd - runStart;
+  std::ostringstream os;
+  os.precision (6);
+  os << "{\"nodes\": " << nodes
+     << ", \"topology\": " << JsonString (topology)
+     << ", \"traffic\": " << JsonString (traffic)
+     << ", \"antenna\": " << JsonString (antenna)
+     << ", \"spacing\": " << spacing
+     << ", \"rate\": " << rate
+     << ", \"packet_size\": " << packetSize
+     << ", \"duration\": " << duration
+     << ", \"seed\": " << seed
+     << ", \"run\": " << run
+     << ", \"setup_s\": " << runStart - setupStart
+     << ", \"run_s\": " << runTime
+     << ", \"destroy_s\": " << destroyEnd - runEnd
+     << ", \"events\": " << events
+     << ", \"cancelled_events\": " << cancelled
+     << ", \"events_per_s\": " << (runTime > 0 ? events / runTime : 0.0)
+     << ", \"sim_s_per_wall_s\": " << (runTime > 0 ? duration / runTime : 0.0)
+     << ", \"peak_rss_kb\": " << usage.ru_maxrss
+     << ", \"frames_generated\": " << g_counters.generated
+     << ", \"phy_tx\": " << g_counters.txBegin
+     << ", \"phy_rx\": " << g_counters.rxEnd
+     << ", \"phy_rx_drop\": " << g_counters.rxDrop
+     << ", \"delivered\": " << g_counters.delivered;
+  if (profile)
+    {
+      const BenchScheduler::Profile &byType = BenchScheduler::GetProfile ();
+      // events are listed by the class they invoke, all members together
+      std::map<std::string, double> byModule;
+      std::map<std::string, std::pair<uint64_t, double> > byClass;
+      for (BenchScheduler::Profile::const_iterator i = byType.begin (); i != byType.end (); i++)
+        {
+          std::string name = Demangle (i->first);
+          std::string cls = EventClass (name);
+          byModule[EventModule (cls)] += i->second.second;
+          std::pair<uint64_t, double> &slot = byClass[cls.empty () ? name : cls];
+          slot.first += i->second.first;
+          slot.second += i->second.second;
+        }
+      std::vector<std::pair<double, std::pair<uint64_t, std::string> > > types;
+      for (std::map<std::string, std::pair<uint64_t, double> >::const_iterator i = byClass.begin ();
+           i != byClass.end (); i++)
+        {
+          types.push_back (std::make_pair (i->second.second,
+                                           std::make_pair (i->second.first, i->first)));
+        }
+      std::sort (types.rbegin (), types.rend ());
+      os << ", \"module_s\": {";
+      for (std::map<std::string, double>::const_iterator i = byModule.begin (); i != byModule.end (); i++)
+        {
+          os << (i == byModule.begin () ? "" : ", ") << JsonString (i->first) << ": " << i->second;
+        }
+      os << "}, \"event_types\": [";
+      for (uint32_t i = 0; i < types.size () && i < topEvents; i++)
+        {
+          os << (i == 0 ? "" : ", ")
+             << "{\"type\": " << JsonString (types[i].second.second)
+             << ", \"count\": " << types[i].second.first
+             << ", \"s\": " << types[i].first << "}";
+        }
+      os << "]";
+    }
+  os << "}";
+
+  if (output == "-")
+    {
+      std::cout << os.str () << std::endl;
+    }
+  else
+    {
+      std::ofstream file (output.c_str (), std::ios::app);
+      NS_ABORT_MSG_IF (!file, "Cannot open " << output);
+      file << os.str () << std::endl;
+    }
+  return 0;
+}
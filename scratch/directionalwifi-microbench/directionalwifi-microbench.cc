@@ -0,0 +1,661 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Microbenchmarks of the hot paths of the directional wifi model.
+ *
+ * Every kernel runs a warm-up pass of a tenth of its iterations, then
+ * the measured pass, and reports the wall clock time and the number of
+ * calls to operator new per operation. The inputs come from the random
+ * number generator seeded with --seed, so two runs measure the same work.
+ *
+ * antenna-gain: GetGainDb (current mode) and GetGainsDb (every mode)
+ * over every ordered pair of a set of random positions, with the
+ * analytic pattern and with the gain table at each of --resolutions,
+ * for each antenna model. --sectors sets the number of sectors of the
+ * switched-beam antenna.
+ *
+ * angles: the Angles constructors from a direction and from a pair of
+ * positions, and NormalizeOverTwoPI.
+ *
+ * geography: GeographyTable::UpdateTable and GetAngle on tables of
+ * 16, 256 and 4096 neighbours.
+ *
+ * interference: InterferenceHelper::Add and CalculateSnrPer for a
+ * frame overlapped by 0, 4, 16 and 64 other signals.
+ *
+ * object-lookup: the per-frame resolution of the mobility model and
+ * node id of a set of PHYs, through GetObject as the channel and MacLow
+ * used to, and through the accessors which cache them.
+ *
+ * --bench selects one of them; all run by default.
+ *
+ *   ./waf --run "directionalwifi-microbench --nodes=200 --rounds=20"
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <time.h>
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/wifiantenna-module.h"
+#include "ns3/angles.h"
+#include "ns3/geography-table.h"
+#include "ns3/interference-helper.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DirectionalWifiMicrobench");
+
+static double g_sink = 0; // keeps the measured loops from being optimized out
+static uint64_t g_allocations = 0;
+
+/*
+ * Count every allocation of the program. The exception specifications
+ * of the replaced operators changed with C++11.
+ */
+#if __cplusplus >= 201103L
+#define BENCH_THROW_BAD_ALLOC
+#define BENCH_NOTHROW noexcept
+#else
+#define BENCH_THROW_BAD_ALLOC throw (std::bad_alloc)
+#define BENCH_NOTHROW throw ()
+#endif
+
+void *
+operator new (std::size_t size) BENCH_THROW_BAD_ALLOC
+{
+  g_allocations++;
+  void *p = std::malloc (size > 0 ? size : 1);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void *
+operator new[] (std::size_t size) BENCH_THROW_BAD_ALLOC
+{
+  return operator new (size);
+}
+
+void
+operator delete (void *p) BENCH_NOTHROW
+{
+  std::free (p);
+}
+
+void
+operator delete[] (void *p) BENCH_NOTHROW
+{
+  std::free (p);
+}
+
+#ifdef __cpp_sized_deallocation
+void
+operator delete (void *p, std::size_t) BENCH_NOTHROW
+{
+  std::free (p);
+}
+
+void
+operator delete[] (void *p, std::size_t) BENCH_NOTHROW
+{
+  std::free (p);
+}
+#endif
+
+static double
+MonotonicSeconds (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Cost of one operation of a kernel.
+ */
+struct Measurement
+{
+  double ns;
+  double allocations;
+};
+
+/**
+ * Run kernel (iterations / 10) times to warm the caches and the lazily
+ * built tables, then iterations times under the clock.
+ *
+ * \param kernel a functor whose Run (n) performs n iterations
+ * \param iterations number of measured iterations
+ * \param opsPerIteration number of operations one iteration performs
+ * \return the cost of one operation
+ */
+template <typename K>
+static Measurement
+Measure (K &kernel, uint32_t iterations, double opsPerIteration)
+{
+  kernel.Run (std::max<uint32_t> (1, iterations / 10));
+  uint64_t allocations = g_allocations;
+  double start = MonotonicSeconds ();
+  kernel.Run (iterations);
+  double seconds = MonotonicSeconds () - start;
+  double ops = iterations * opsPerIteration;
+  Measurement m;
+  m.ns = seconds * 1e9 / ops;
+  m.allocations = (g_allocations - allocations) / ops;
+  return m;
+}
+
+static void
+PrintMeasurement (const Measurement &m)
+{
+  std::cout << std::setw (12) << std::right << std::fixed << std::setprecision (1) << m.ns
+            << std::setw (12) << std::setprecision (2) << m.allocations;
+}
+
+static std::vector<Ptr<MobilityModel> >
+CreatePositions (uint32_t nodes, double side)
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  x->SetAttribute ("Max", DoubleValue (side));
+  std::vector<Ptr<MobilityModel> > positions;
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      Ptr<ConstantPositionMobilityModel> m = CreateObject<ConstantPositionMobilityModel> ();
+      m->SetPosition (Vector (x->GetValue (), x->GetValue (), 0));
+      positions.push_back (m);
+    }
+  return positions;
+}
+
+static std::vector<Vector>
+CreateVectors (uint32_t n, double side)
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  x->SetAttribute ("Min", DoubleValue (-side / 2));
+  x->SetAttribute ("Max", DoubleValue (side / 2));
+  std::vector<Vector> vectors;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      vectors.push_back (Vector (x->GetValue (), x->GetValue (), x->GetValue () / 10));
+    }
+  return vectors;
+}
+
+/**
+ * One iteration is a pass of GetGainDb or GetGainsDb over every
+ * ordered pair of positions.
+ */
+struct GainKernel
+{
+  Ptr<WifiAntennaModel> antenna;
+  const std::vector<Ptr<MobilityModel> > *positions;
+  bool allModes;
+
+  void Run (uint32_t iterations)
+  {
+    double gains[WifiAntennaModel::MAX_ANTENNA_MODES];
+    const std::vector<Ptr<MobilityModel> > &p = *positions;
+    for (uint32_t r = 0; r < iterations; r++)
+      {
+        for (uint32_t i = 0; i < p.size (); i++)
+          {
+            for (uint32_t j = 0; j < p.size (); j++)
+              {
+                if (i == j)
+                  {
+                    continue;
+                  }
+                if (allModes)
+                  {
+                    antenna->GetGainsDb (p[i], p[j], gains);
+                    g_sink += gains[0];
+                  }
+                else
+                  {
+                    g_sink += antenna->GetGainDb (p[i], p[j]);
+                  }
+              }
+          }
+      }
+  }
+};
+
+static std::vector<double>
+ParseList (const std::string &list)
+{
+  std::vector<double> values;
+  std::istringstream is (list);
+  std::string item;
+  while (std::getline (is, item, ','))
+    {
+      values.push_back (std::atof (item.c_str ()));
+    }
+  return values;
+}
+
+static void
+BenchAntennaGain (uint32_t nodes, uint32_t rounds, const std::vector<double> &resolutions)
+{
+  const char *types[] = { "ns3::WifiCosineAntennaModel",
+                          "ns3::WifiParabolicAntennaModel",
+                          "ns3::WifiSwitchedBeamAntennaModel" };
+  std::vector<Ptr<MobilityModel> > positions = CreatePositions (nodes, 1000);
+  double pairs = static_cast<double> (nodes) * (nodes - 1);
+
+  std::cout << "antenna-gain: " << nodes << " nodes, " << rounds << " rounds" << std::endl;
+  std::cout << std::setw (34) << std::left << "model"
+            << std::setw (10) << "table"
+            << std::setw (12) << std::right << "gain ns"
+            << std::setw (12) << "allocs"
+            << std::setw (12) << "gains ns"
+            << std::setw (12) << "allocs" << std::endl;
+  for (uint32_t t = 0; t < sizeof (types) / sizeof (types[0]); t++)
+    {
+      for (uint32_t r = 0; r <= resolutions.size (); r++)
+        {
+          ObjectFactory factory;
+          factory.SetTypeId (types[t]);
+          GainKernel kernel;
+          kernel.antenna = factory.Create<WifiAntennaModel> ();
+          kernel.positions = &positions;
+          std::ostringstream table;
+          if (r == 0)
+            {
+              table << "analytic";
+            }
+          else
+            {
+              kernel.antenna->SetAttribute ("UseGainTable", BooleanValue (true));
+              kernel.antenna->SetAttribute ("GainTableResolution", DoubleValue (resolutions[r - 1]));
+              table << resolutions[r - 1] << " deg";
+            }
+          std::cout << std::setw (34) << std::left << types[t]
+                    << std::setw (10) << table.str ();
+          kernel.allModes = false;
+          PrintMeasurement (Measure (kernel, rounds, pairs));
+          kernel.allModes = true;
+          PrintMeasurement (Measure (kernel, rounds, pairs));
+          std::cout << std::endl;
+        }
+    }
+}
+
+/**
+ * One iteration is a pass over the inputs of the selected function.
+ */
+struct AnglesKernel
+{
+  enum Function
+  {
+    FROM_DIRECTION,
+    FROM_POSITIONS,
+    NORMALIZE
+  };
+  Function function;
+  const std::vector<Vector> *vectors;
+  const std::vector<double> *radians;
+
+  void Run (uint32_t iterations)
+  {
+    const std::vector<Vector> &v = *vectors;
+    const std::vector<double> &a = *radians;
+    for (uint32_t r = 0; r < iterations; r++)
+      {
+        switch (function)
+          {
+          case FROM_DIRECTION:
+            for (uint32_t i = 0; i < v.size (); i++)
+              {
+                g_sink += Angles (v[i]).phi;
+              }
+            break;
+          case FROM_POSITIONS:
+            for (uint32_t i = 1; i < v.size (); i++)
+              {
+                g_sink += Angles (v[i], v[i - 1]).phi;
+              }
+            break;
+          case NORMALIZE:
+            for (uint32_t i = 0; i < a.size (); i++)
+              {
+                g_sink += NormalizeOverTwoPI (a[i]);
+              }
+            break;
+          }
+      }
+  }
+};
+
+static void
+BenchAngles (uint32_t iterations)
+{
+  const uint32_t n = 4096;
+  AnglesKernel kernel;
+  std::vector<Vector> vectors = CreateVectors (n, 1000);
+  Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+  u->SetAttribute ("Min", DoubleValue (-8 * M_PI));
+  u->SetAttribute ("Max", DoubleValue (8 * M_PI));
+  std::vector<double> radians;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      radians.push_back (u->GetValue ());
+    }
+  kernel.vectors = &vectors;
+  kernel.radians = &radians;
+
+  std::cout << "angles: " << n << " inputs, " << iterations << " rounds" << std::endl;
+  std::cout << std::setw (34) << std::left << "function"
+            << std::setw (12) << std::right << "ns"
+            << std::setw (12) << "allocs" << std::endl;
+  const char *names[] = { "Angles (Vector)", "Angles (Vector, Vector)", "NormalizeOverTwoPI" };
+  AnglesKernel::Function functions[] = { AnglesKernel::FROM_DIRECTION,
+                                         AnglesKernel::FROM_POSITIONS,
+                                         AnglesKernel::NORMALIZE };
+  double ops[] = { n, n - 1, n };
+  for (uint32_t f = 0; f < 3; f++)
+    {
+      kernel.function = functions[f];
+      std::cout << std::setw (34) << std::left << names[f];
+      PrintMeasurement (Measure (kernel, iterations, ops[f]));
+      std::cout << std::endl;
+    }
+}
+
+static Mac48Address
+MakeAddress (uint32_t i)
+{
+  uint8_t buffer[6] = { 0x02, 0, static_cast<uint8_t> (i >> 24), static_cast<uint8_t> (i >> 16),
+                        static_cast<uint8_t> (i >> 8), static_cast<uint8_t> (i) };
+  Mac48Address address;
+  address.CopyFrom (buffer);
+  return address;
+}
+
+/**
+ * One iteration updates, or looks up the angle to, every neighbour
+ * of the table once.
+ */
+struct GeographyKernel
+{
+  Ptr<GeographyTable> table;
+  const std::vector<Mac48Address> *addresses;
+  const std::vector<Vector> *positions;
+  bool update;
+
+  void Run (uint32_t iterations)
+  {
+    const std::vector<Mac48Address> &a = *addresses;
+    const std::vector<Vector> &p = *positions;
+    bool exists;
+    for (uint32_t r = 0; r < iterations; r++)
+      {
+        for (uint32_t i = 0; i < a.size (); i++)
+          {
+            // visit the neighbours out of insertion order
+            uint32_t k = (i * 2654435761u + r) % a.size ();
+            if (update)
+              {
+                table->UpdateTable (a[k], p[(k + r) % p.size ()]);
+              }
+            else
+              {
+                g_sink += table->GetAngle (a[k], p[i], &exists).phi;
+              }
+          }
+      }
+  }
+};
+
+static void
+BenchGeography (uint32_t iterations)
+{
+  const uint32_t sizes[] = { 16, 256, 4096 };
+  std::cout << "geography: " << iterations << " rounds" << std::endl;
+  std::cout << std::setw (34) << std::left << "neighbours"
+            << std::setw (12) << std::right << "update ns"
+            << std::setw (12) << "allocs"
+            << std::setw (12) << "angle ns"
+            << std::setw (12) << "allocs" << std::endl;
+  for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+    {
+      std::vector<Mac48Address> addresses;
+      for (uint32_t i = 0; i < sizes[s]; i++)
+        {
+          addresses.push_back (MakeAddress (i));
+        }
+      std::vector<Vector> positions = CreateVectors (sizes[s], 1000);
+      GeographyKernel kernel;
+      kernel.table = CreateObject<GeographyTable> ();
+      kernel.addresses = &addresses;
+      kernel.positions = &positions;
+      // every neighbour is known before the lookups are timed
+      for (uint32_t i = 0; i < sizes[s]; i++)
+        {
+          kernel.table->UpdateTable (addresses[i], positions[i]);
+        }
+      // keep the number of operations per size about constant
+      uint32_t rounds = std::max<uint32_t> (1, iterations * 256 / sizes[s]);
+      std::cout << std::setw (34) << std::left << sizes[s];
+      kernel.update = true;
+      PrintMeasurement (Measure (kernel, rounds, sizes[s]));
+      kernel.update = false;
+      PrintMeasurement (Measure (kernel, rounds, sizes[s]));
+      std::cout << std::endl;
+    }
+}
+
+/**
+ * One iteration adds overlap interfering signals and the frame to an
+ * empty helper and, unless addOnly, computes the SNR and PER of the
+ * frame. The interferers end at spread times within the frame, so that
+ * each contributes a change of the noise during its reception.
+ */
+struct InterferenceKernel
+{
+  InterferenceHelper *helper;
+  uint32_t overlap;
+  bool addOnly;
+
+  void Run (uint32_t iterations)
+  {
+    WifiMode mode = WifiPhy::GetOfdmRate6Mbps ();
+    WifiTxVector txVector;
+    txVector.SetMode (mode);
+    Time frame = MicroSeconds (1000);
+    PerModePower signal (1, 1e-9);
+    PerModePower interference (1, 1e-12);
+    for (uint32_t r = 0; r < iterations; r++)
+      {
+        helper->EraseEvents ();
+        for (uint32_t i = 0; i < overlap; i++)
+          {
+            helper->Add (1000, mode, WIFI_PREAMBLE_LONG,
+                         frame * (i + 1) / (overlap + 1), interference, txVector);
+          }
+        Ptr<InterferenceHelper::Event> event =
+          helper->Add (1000, mode, WIFI_PREAMBLE_LONG, frame, signal, txVector);
+        if (!addOnly)
+          {
+            helper->NotifyRxStart ();
+            g_sink += helper->CalculateSnrPer (event).snr;
+            helper->NotifyRxEnd ();
+          }
+      }
+  }
+};
+
+static void
+BenchInterference (uint32_t iterations)
+{
+  const uint32_t overlaps[] = { 0, 4, 16, 64 };
+  std::cout << "interference: " << iterations << " rounds" << std::endl;
+  std::cout << std::setw (34) << std::left << "overlapping signals"
+            << std::setw (12) << std::right << "add ns"
+            << std::setw (12) << "allocs"
+            << std::setw (12) << "snr-per ns"
+            << std::setw (12) << "allocs" << std::endl;
+  for (uint32_t o = 0; o < sizeof (overlaps) / sizeof (overlaps[0]); o++)
+    {
+      InterferenceHelper helper;
+      helper.SetNoiseFigure (DbToRatio (7));
+      helper.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+      InterferenceKernel kernel;
+      kernel.helper = &helper;
+      kernel.overlap = overlaps[o];
+      kernel.addOnly = true;
+      Measurement add = Measure (kernel, iterations, overlaps[o] + 1);
+      kernel.addOnly = false;
+      Measurement all = Measure (kernel, iterations, 1);
+      // the SNR computation is what the full iteration costs on top
+      // of filling the helper.
+      Measurement snr;
+      snr.ns = all.ns - add.ns * (overlaps[o] + 1);
+      snr.allocations = all.allocations - add.allocations * (overlaps[o] + 1);
+      std::cout << std::setw (34) << std::left << overlaps[o];
+      PrintMeasurement (add);
+      PrintMeasurement (snr);
+      std::cout << std::endl;
+    }
+}
+
+/**
+ * One iteration resolves the position and node id of every PHY once,
+ * as Send does.
+ */
+struct LookupKernel
+{
+  const std::vector<Ptr<YansWifiPhy> > *phys;
+  bool cached;
+
+  void Run (uint32_t iterations)
+  {
+    const std::vector<Ptr<YansWifiPhy> > &p = *phys;
+    for (uint32_t r = 0; r < iterations; r++)
+      {
+        for (uint32_t i = 0; i < p.size (); i++)
+          {
+            if (cached)
+              {
+                g_sink += p[i]->PeekMobilityModel ()->GetPosition ().x;
+                g_sink += p[i]->GetNodeId ();
+              }
+            else
+              {
+                Ptr<MobilityModel> mobility = p[i]->GetMobility ()->GetObject<MobilityModel> ();
+                g_sink += mobility->GetPosition ().x;
+                g_sink += p[i]->GetDevice ()->GetObject<NetDevice> ()->GetNode ()->GetId ();
+              }
+          }
+      }
+  }
+};
+
+static void
+BenchObjectLookup (uint32_t nodes, uint32_t rounds)
+{
+  std::vector<Ptr<MobilityModel> > positions = CreatePositions (nodes, 1000);
+  std::vector<Ptr<YansWifiPhy> > phys;
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      node->AggregateObject (positions[i]);
+      Ptr<WifiNetDevice> device = CreateObject<WifiNetDevice> ();
+      node->AddDevice (device);
+      Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+      phy->SetMobility (node);
+      phy->SetDevice (device);
+      phys.push_back (phy);
+    }
+  LookupKernel kernel;
+  kernel.phys = &phys;
+  // as many lookups as a frame sent to every other node costs
+  uint32_t passes = rounds * nodes;
+
+  std::cout << "object-lookup: " << nodes << " nodes, " << rounds << " rounds" << std::endl;
+  std::cout << std::setw (34) << std::left << "path"
+            << std::setw (12) << std::right << "ns"
+            << std::setw (12) << "allocs" << std::endl;
+  kernel.cached = false;
+  std::cout << std::setw (34) << std::left << "GetObject";
+  PrintMeasurement (Measure (kernel, passes, nodes));
+  std::cout << std::endl;
+  kernel.cached = true;
+  std::cout << std::setw (34) << std::left << "cached";
+  PrintMeasurement (Measure (kernel, passes, nodes));
+  std::cout << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodes = 200;
+  uint32_t rounds = 20;
+  uint32_t iterations = 1000;
+  std::string resolutions = "1,0.25";
+  uint32_t sectors = 4;
+  uint32_t seed = 1;
+  std::string bench = "all";
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Number of random positions", nodes);
+  cmd.AddValue ("rounds", "Number of passes over every pair of positions", rounds);
+  cmd.AddValue ("iterations", "Number of measured rounds of the angles, geography and interference kernels", iterations);
+  cmd.AddValue ("resolutions", "Comma separated angular steps (degrees) of the gain tables", resolutions);
+  cmd.AddValue ("sectors", "Number of sectors of the switched-beam antenna", sectors);
+  cmd.AddValue ("seed", "Seed of the random inputs", seed);
+  cmd.AddValue ("bench", "Benchmark to run: antenna-gain, angles, geography, interference, object-lookup or all", bench);
+  cmd.Parse (argc, argv);
+
+  RngSeedManager::SetSeed (seed);
+  RngSeedManager::SetRun (1);
+  Config::SetDefault ("ns3::WifiSwitchedBeamAntennaModel::Sectors", UintegerValue (sectors));
+
+  if (bench == "all" || bench == "antenna-gain")
+    {
+      BenchAntennaGain (nodes, rounds, ParseList (resolutions));
+    }
+  if (bench == "all" || bench == "angles")
+    {
+      BenchAngles (iterations);
+    }
+  if (bench == "all" || bench == "geography")
+    {
+      BenchGeography (iterations);
+    }
+  if (bench == "all" || bench == "interference")
+    {
+      BenchInterference (iterations);
+    }
+  if (bench == "all" || bench == "object-lookup")
+    {
+      BenchObjectLookup (nodes, rounds);
+    }
+  std::cerr << "(" << g_sink << ")" << std::endl;
+  return 0;
+}
@@ -34,7 +34,7 @@
 #include "ns3/abort.h"
 #include "ns3/log.h"
 
-#include "ns3/wifi-switched-beam-antenna-model.h"
+#include "ns3/wifi-antenna-model.h"
 #include "ns3/constant-orientation-model.h"
 
 NS_LOG_COMPONENT_DEFINE ("YansWifiHelper");
@@ -187,6 +187,7 @@ YansWifiPhyHelper::YansWifiPhyHelper ()
     m_pcapDlt (PcapHelper::DLT_IEEE802_11)
 {
   m_phy.SetTypeId ("ns3::YansWifiPhy");
+  m_antenna.SetTypeId ("ns3::WifiSwitchedBeamAntennaModel");
 }
 
 YansWifiPhyHelper
@@ -238,13 +239,36 @@ YansWifiPhyHelper::SetErrorRateModel (std::string name,
   m_errorRateModel.Set (n7, v7);
 }
 
+void
+YansWifiPhyHelper::SetAntenna (std::string name,
+                               std::string n0, const AttributeValue &v0,
+                               std::string n1, const AttributeValue &v1,
+                               std::string n2, const AttributeValue &v2,
+                               std::string n3, const AttributeValue &v3,
+                               std::string n4, const AttributeValue &v4,
+                               std::string n5, const AttributeValue &v5,
+                               std::string n6, const AttributeValue &v6,
+                               std::string n7, const AttributeValue &v7)
+{
+  m_antenna = ObjectFactory ();
+  m_antenna.SetTypeId (name);
+  m_antenna.Set (n0, v0);
+  m_antenna.Set (n1, v1);
+  m_antenna.Set (n2, v2);
+  m_antenna.Set (n3, v3);
+  m_antenna.Set (n4, v4);
+  m_antenna.Set (n5, v5);
+  m_antenna.Set (n6, v6);
+  m_antenna.Set (n7, v7);
+}
+
 Ptr<WifiPhy>
 YansWifiPhyHelper::Create (Ptr<Node> node, Ptr<WifiNetDevice> device) const
 {
   Ptr<YansWifiPhy> phy = m_phy.Create<YansWifiPhy> ();
   Ptr<ErrorRateModel> error = m_errorRateModel.Create<ErrorRateModel> ();
   Ptr<OrientationModel> orientation = CreateObject<ConstantOrientationModel> ();
-  Ptr<WifiAntennaModel> antenna = CreateObject<WifiSwitchedBeamAntennaModel> ();
+  Ptr<WifiAntennaModel> antenna = m_antenna.Create<WifiAntennaModel> ();
   antenna->SetOrientationModel (orientation);
   phy->SetAntenna (antenna);
   phy->SetErrorRateModel (error);
@@ -182,29 +182,6 @@ DcfState::NotifyNextTransmission (DcfManager* manager)
   DoNotifyNextTransmission (manager);
 }
 
-class AntennaListener : public ns3::WifiAntennaListener
-{
-public:
-  /**
-   * Create a AntennaListener for the given DcfManager.
-   *
-   * \param dcf
-   */
-  AntennaListener (ns3::DcfManager *dcf)
-    : m_dcf (dcf)
-  {
-  }
-  virtual ~AntennaListener ()
-  {
-  }
-  virtual void NotifyChangeAntennaMode (int mode)
-  {
-    m_dcf->NotifyChangeAntennaModeNow (mode);
-  }
-private:
-  ns3::DcfManager *m_dcf;  //!< DcfManager to forward events to
-};
-
 /**
  * Listener for NAV events. Forwards to DcfManager
  */
@@ -289,6 +266,10 @@ public:
   {
     m_dcf->NotifyMaybeCcaBusyStartNow (duration);
   }
+  virtual void NotifyMaybeCcaBusyStartForMode (Time duration, int mode)
+  {
+    m_dcf->NotifyMaybeCcaBusyStartNow (duration, mode);
+  }
   virtual void NotifySwitchingStart (Time duration)
   {
     m_dcf->NotifySwitchingStartNow (duration);
@@ -312,43 +293,36 @@ DcfManager::DcfManager ()
     m_lastTxDuration (MicroSeconds (0)),
     m_lastSwitchingStart (MicroSeconds (0)),
     m_lastSwitchingDuration (MicroSeconds (0)),
-    m_antennaMode (0),
-    m_nextAntennaMode (0),
+    m_antennaState (Create<WifiAntennaState> ()),
     m_rxing (false),
     m_slotTimeUs (0),
     m_sifs (Seconds (0.0)),
-    m_antennaListener (0),
     m_phyListener (0),
     m_lowListener (0)
 {
   NS_LOG_FUNCTION (this);
-  for(int i = 0; i < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
+  for(int i = 0; i < WifiAntennaModel::MAX_ANTENNA_MODES; i++){
     m_lastNavStart     [i] = MicroSeconds (0);
     m_lastNavDuration  [i] = MicroSeconds (0);
     m_lastBusyStart    [i] = MicroSeconds (0);
     m_lastBusyDuration [i] = MicroSeconds (0);
   }
+  UpdateAccessGrantStart ();
+  m_accessTimeout.SetFunction (MakeCallback (&DcfManager::AccessTimeout, this));
 }
 
 DcfManager::~DcfManager ()
 {
-  delete m_antennaListener;
   delete m_phyListener;
   delete m_lowListener;
-  m_antennaListener = 0;
   m_phyListener = 0;
   m_lowListener = 0;
 }
 void
-DcfManager::SetupAntennaListener (Ptr<WifiAntennaModel> antenna)
+DcfManager::SetupAntennaState (Ptr<WifiAntennaModel> antenna)
 {
   NS_LOG_FUNCTION (this << antenna);
-  if (m_antennaListener != 0)
-    {
-      delete m_antennaListener;
-    }
-  m_antennaListener = new AntennaListener (this);
-  antenna->RegisterListener (m_antennaListener);
+  m_antennaState = antenna->GetState ();
 }
 void
 DcfManager::SetupPhyListener (Ptr<WifiPhy> phy)
@@ -384,12 +358,14 @@ DcfManager::SetSifs (Time sifs)
 {
   NS_LOG_FUNCTION (this << sifs);
   m_sifs = sifs;
+  UpdateAccessGrantStart ();
 }
 void
 DcfManager::SetEifsNoDifs (Time eifsNoDifs)
 {
   NS_LOG_FUNCTION (this << eifsNoDifs);
   m_eifsNoDifs = eifsNoDifs;
+  UpdateCommonAccessStart ();
 }
 Time
 DcfManager::GetEifsNoDifs () const
@@ -398,6 +374,12 @@ DcfManager::GetEifsNoDifs () const
   return m_eifsNoDifs;
 }
 
+const WifiLazyTimer &
+DcfManager::GetAccessTimeoutTimer (void) const
+{
+  return m_accessTimeout;
+}
+
 void
 DcfManager::Add (DcfState *dcf)
 {
@@ -469,7 +451,7 @@ DcfManager::IsBusy (void) const
       return true;
     }
   // NAV busy
-  Time lastNavEnd = m_lastNavStart [m_nextAntennaMode] + m_lastNavDuration [m_nextAntennaMode];
+  Time lastNavEnd = m_lastNavStart [m_antennaState->nextMode] + m_lastNavDuration [m_antennaState->nextMode];
   if (lastNavEnd > Simulator::Now ())
     {
       return true;
@@ -486,14 +468,12 @@ DcfManager::RequestAccess (DcfState *state)
   NS_ASSERT (!state->IsAccessRequested ());
   state->NotifyAccessRequested ();
   state->NotifyNextTransmission (this);
+  // NotifyNextTransmission draws a new backoff, which may start in the
+  // past, and may switch the next antenna mode, which moves the access
+  // grant start of every state: count the slots elapsed since then.
+  // The first UpdateBackoff counted those of the previous mode.
   UpdateBackoff ();
-
-  for(int i = 0; i < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
-    NS_LOG_INFO (i << ":[busy] " << m_lastBusyStart [i] + m_lastBusyDuration [i] + m_sifs);
-  }
-  for(int i = 0; i < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
-    NS_LOG_INFO (i << ":[ nav] " << m_lastNavStart [i] + m_lastNavDuration [i] + m_sifs);
-  }
+  NS_LOG_INFO ("mode " << m_antennaState->nextMode << ": access grant start " << GetAccessGrantStart ());
 
   /**
    * If there is a collision, generate a backoff
@@ -576,10 +556,9 @@ DcfManager::AccessTimeout (void)
   DoRestartAccessTimeoutIfNeeded ();
 }
 
-Time
-DcfManager::GetAccessGrantStart (void) const
+void
+DcfManager::UpdateCommonAccessStart (void)
 {
-  NS_LOG_FUNCTION (this);
   Time rxAccessStart;
   if (!m_rxing)
     {
@@ -593,25 +572,44 @@ DcfManager::GetAccessGrantStart (void) const
     {
       rxAccessStart = m_lastRxStart + m_lastRxDuration + m_sifs;
     }
-  Time busyAccessStart = m_lastBusyStart [m_nextAntennaMode] + m_lastBusyDuration [m_nextAntennaMode] + m_sifs;
   Time txAccessStart = m_lastTxStart + m_lastTxDuration + m_sifs;
-  Time navAccessStart = m_lastNavStart [m_nextAntennaMode] + m_lastNavDuration [m_nextAntennaMode] + m_sifs;
   Time ackTimeoutAccessStart = m_lastAckTimeoutEnd + m_sifs;
   Time ctsTimeoutAccessStart = m_lastCtsTimeoutEnd + m_sifs;
   Time switchingAccessStart = m_lastSwitchingStart + m_lastSwitchingDuration + m_sifs;
-  Time accessGrantedStart = MostRecent (rxAccessStart,
-                                        busyAccessStart,
-                                        txAccessStart,
-                                        navAccessStart,
-                                        ackTimeoutAccessStart,
-                                        ctsTimeoutAccessStart,
-                                        switchingAccessStart
-                                        );
+  m_commonAccessStart = MostRecent (MostRecent (rxAccessStart,
+                                                txAccessStart,
+                                                ackTimeoutAccessStart,
+                                                ctsTimeoutAccessStart),
+                                    switchingAccessStart);
+}
+
+void
+DcfManager::UpdateModeAccessStart (int mode)
+{
+  Time busyAccessStart = m_lastBusyStart [mode] + m_lastBusyDuration [mode] + m_sifs;
+  Time navAccessStart = m_lastNavStart [mode] + m_lastNavDuration [mode] + m_sifs;
+  m_modeAccessStart [mode] = MostRecent (busyAccessStart, navAccessStart);
+}
+
+void
+DcfManager::UpdateAccessGrantStart (void)
+{
+  UpdateCommonAccessStart ();
+  for (int mode = 0; mode < WifiAntennaModel::MAX_ANTENNA_MODES; mode++)
+    {
+      UpdateModeAccessStart (mode);
+    }
+}
+
+Time
+DcfManager::GetAccessGrantStart (void) const
+{
+  NS_LOG_FUNCTION (this);
+  int mode = m_antennaState->nextMode;
+  Time accessGrantedStart = MostRecent (m_commonAccessStart, m_modeAccessStart [mode]);
   NS_LOG_INFO ("access grant start=" << accessGrantedStart <<
-               ", rx access start=" << rxAccessStart <<
-               ", busy access start=" << busyAccessStart <<
-               ", tx access start=" << txAccessStart <<
-               ", nav access start=" << navAccessStart);
+               ", rx/tx/timeout/switching access start=" << m_commonAccessStart <<
+               ", busy/nav access start=" << m_modeAccessStart [mode]);
   return accessGrantedStart;
 }
 
@@ -679,26 +677,14 @@ DcfManager::DoRestartAccessTimeoutIfNeeded (void)
   if (accessTimeoutNeeded)
     {
       MY_DEBUG ("expected backoff end=" << expectedBackoffEnd);
-      Time expectedBackoffDelay = expectedBackoffEnd - Simulator::Now ();
-      if (m_accessTimeout.IsRunning ()
-          && Simulator::GetDelayLeft (m_accessTimeout) > expectedBackoffDelay)
-        {
-          m_accessTimeout.Cancel ();
-        }
-      if (m_accessTimeout.IsExpired ())
+      if (!m_accessTimeout.IsRunning ()
+          || m_accessTimeout.GetDeadline () != expectedBackoffEnd)
         {
-          m_accessTimeout = Simulator::Schedule (expectedBackoffDelay,
-                                                 &DcfManager::AccessTimeout, this);
+          m_accessTimeout.ScheduleAt (expectedBackoffEnd);
         }
     }
 }
 void
-DcfManager::NotifyChangeAntennaModeNow (int mode)
-{
-  NS_LOG_FUNCTION (this << mode);
-  m_antennaMode = mode;
-}
-void
 DcfManager::NotifyRxStartNow (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
@@ -707,6 +693,7 @@ DcfManager::NotifyRxStartNow (Time duration)
   m_lastRxStart = Simulator::Now ();
   m_lastRxDuration = duration;
   m_rxing = true;
+  UpdateCommonAccessStart ();
 }
 void
 DcfManager::NotifyRxEndOkNow (void)
@@ -716,6 +703,7 @@ DcfManager::NotifyRxEndOkNow (void)
   m_lastRxEnd = Simulator::Now ();
   m_lastRxReceivedOk = true;
   m_rxing = false;
+  UpdateCommonAccessStart ();
 }
 void
 DcfManager::NotifyRxEndErrorNow (void)
@@ -725,6 +713,7 @@ DcfManager::NotifyRxEndErrorNow (void)
   m_lastRxEnd = Simulator::Now ();
   m_lastRxReceivedOk = false;
   m_rxing = false;
+  UpdateCommonAccessStart ();
 }
 void
 DcfManager::NotifyTxStartNow (Time duration)
@@ -745,15 +734,22 @@ DcfManager::NotifyTxStartNow (Time duration)
   UpdateBackoff ();
   m_lastTxStart = Simulator::Now ();
   m_lastTxDuration = duration;
+  UpdateCommonAccessStart ();
 }
 void
 DcfManager::NotifyMaybeCcaBusyStartNow (Time duration)
 {
-  NS_LOG_FUNCTION (this << duration);
+  NotifyMaybeCcaBusyStartNow (duration, m_antennaState->mode);
+}
+void
+DcfManager::NotifyMaybeCcaBusyStartNow (Time duration, int mode)
+{
+  NS_LOG_FUNCTION (this << duration << mode);
   MY_DEBUG ("busy start for " << duration);
   UpdateBackoff ();
-  m_lastBusyStart [m_antennaMode] = Simulator::Now ();
-  m_lastBusyDuration [m_antennaMode] = duration;
+  m_lastBusyStart [mode] = Simulator::Now ();
+  m_lastBusyDuration [mode] = duration;
+  UpdateModeAccessStart (mode);
 }
 
 
@@ -773,13 +769,13 @@ DcfManager::NotifySwitchingStartNow (Time duration)
       m_lastRxReceivedOk = true;
       m_rxing = false;
     }
-  if (m_lastNavStart [m_antennaMode] + m_lastNavDuration [m_antennaMode] > now)
+  if (m_lastNavStart [m_antennaState->mode] + m_lastNavDuration [m_antennaState->mode] > now)
     {
-      m_lastNavDuration [m_antennaMode] = now - m_lastNavStart [m_antennaMode];
+      m_lastNavDuration [m_antennaState->mode] = now - m_lastNavStart [m_antennaState->mode];
     }
-  if (m_lastBusyStart [m_antennaMode] + m_lastBusyDuration [m_antennaMode] > now)
+  if (m_lastBusyStart [m_antennaState->mode] + m_lastBusyDuration [m_antennaState->mode] > now)
     {
-      m_lastBusyDuration [m_antennaMode] = now - m_lastBusyStart [m_antennaMode];
+      m_lastBusyDuration [m_antennaState->mode] = now - m_lastBusyStart [m_antennaState->mode];
     }
   if (m_lastAckTimeoutEnd > now)
     {
@@ -791,10 +787,7 @@ DcfManager::NotifySwitchingStartNow (Time duration)
     }
 
   // Cancel timeout
-  if (m_accessTimeout.IsRunning ())
-    {
-      m_accessTimeout.Cancel ();
-    }
+  m_accessTimeout.Cancel ();
 
   // Reset backoffs
   for (States::iterator i = m_states.begin (); i != m_states.end (); i++)
@@ -814,7 +807,8 @@ DcfManager::NotifySwitchingStartNow (Time duration)
   MY_DEBUG ("switching start for " << duration);
   m_lastSwitchingStart = Simulator::Now ();
   m_lastSwitchingDuration = duration;
-
+  UpdateModeAccessStart (m_antennaState->mode);
+  UpdateCommonAccessStart ();
 }
 
 void
@@ -823,8 +817,9 @@ DcfManager::NotifyNavResetNow (Time duration)
   NS_LOG_FUNCTION (this << duration);
   MY_DEBUG ("nav reset for=" << duration);
   UpdateBackoff ();
-  m_lastNavStart [m_antennaMode] = Simulator::Now ();
-  m_lastNavDuration [m_antennaMode] = duration;
+  m_lastNavStart [m_antennaState->mode] = Simulator::Now ();
+  m_lastNavDuration [m_antennaState->mode] = duration;
+  UpdateModeAccessStart (m_antennaState->mode);
   UpdateBackoff ();
   /**
    * If the nav reset indicates an end-of-nav which is earlier
@@ -849,6 +844,7 @@ DcfManager::NotifyNavStartNow (Time duration, int mode)
     {
       m_lastNavStart [WifiSwitchedBeamAntennaModel::OMNI] = Simulator::Now ();
       m_lastNavDuration [WifiSwitchedBeamAntennaModel::OMNI] = duration;
+      UpdateModeAccessStart (WifiSwitchedBeamAntennaModel::OMNI);
     }
   newNavEnd = Simulator::Now () + duration;
   lastNavEnd = m_lastNavStart [mode] + m_lastNavDuration [mode];
@@ -856,6 +852,7 @@ DcfManager::NotifyNavStartNow (Time duration, int mode)
     {
       m_lastNavStart [mode] = Simulator::Now ();
       m_lastNavDuration [mode] = duration;
+      UpdateModeAccessStart (mode);
     }
 }
 void
@@ -864,12 +861,14 @@ DcfManager::NotifyAckTimeoutStartNow (Time duration)
   NS_LOG_FUNCTION (this << duration);
   NS_ASSERT (m_lastAckTimeoutEnd < Simulator::Now ());
   m_lastAckTimeoutEnd = Simulator::Now () + duration;
+  UpdateCommonAccessStart ();
 }
 void
 DcfManager::NotifyAckTimeoutResetNow ()
 {
   NS_LOG_FUNCTION (this);
   m_lastAckTimeoutEnd = Simulator::Now ();
+  UpdateCommonAccessStart ();
   DoRestartAccessTimeoutIfNeeded ();
 }
 void
@@ -877,18 +876,20 @@ DcfManager::NotifyCtsTimeoutStartNow (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
   m_lastCtsTimeoutEnd = Simulator::Now () + duration;
+  UpdateCommonAccessStart ();
 }
 void
 DcfManager::NotifyCtsTimeoutResetNow ()
 {
   NS_LOG_FUNCTION (this);
   m_lastCtsTimeoutEnd = Simulator::Now ();
+  UpdateCommonAccessStart ();
   DoRestartAccessTimeoutIfNeeded ();
 }
 void
 DcfManager::SetNextAntennaMode (int mode)
 {
   NS_LOG_FUNCTION (this << mode);
-  m_nextAntennaMode = mode;
+  m_antennaState->nextMode = mode;
 }
 } // namespace ns3
@@ -23,6 +23,7 @@
 
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "wifi-lazy-timer.h"
 #include "ns3/wifi-antenna-model.h"
 #include <vector>
 
@@ -31,7 +32,6 @@ namespace ns3 {
 class WifiPhy;
 class WifiMac;
 class MacLow;
-class AntennaListener;
 class PhyListener;
 class LowDcfListener;
 class DcfManager;
@@ -240,11 +240,12 @@ public:
   DcfManager ();
   ~DcfManager ();
   /**
-   * Set up listener for Antenna events.
+   * Share the mode of the antenna, which selects the per-mode NAV and
+   * busy state used for access decisions.
    *
    * \param antenna
    */
-  void SetupAntennaListener (Ptr<WifiAntennaModel> antenna);
+  void SetupAntennaState (Ptr<WifiAntennaModel> antenna);
   /**
    * Set up listener for Phy events.
    *
@@ -285,6 +286,11 @@ public:
    * \return value set previously using SetEifsNoDifs.
    */
   Time GetEifsNoDifs () const;
+  /**
+   * \return the timer which drives AccessTimeout, whose counters
+   *         tell how many of its events fired or went stale.
+   */
+  const WifiLazyTimer & GetAccessTimeoutTimer (void) const;
 
   /**
    * \param dcf a new DcfState.
@@ -339,6 +345,14 @@ public:
    * Notify the DCF that a CCA busy period has just started.
    */
   void NotifyMaybeCcaBusyStartNow (Time duration);
+  /**
+   * \param duration expected duration of cca busy period
+   * \param mode the antenna mode the medium is busy in
+   *
+   * Notify the DCF that a CCA busy period has just started in the
+   * given antenna mode, which need not be the current one.
+   */
+  void NotifyMaybeCcaBusyStartNow (Time duration, int mode);
   /**
    * \param duration expected duration of channel switching period
    *
@@ -379,7 +393,6 @@ public:
    * Notify that CTS timer has resetted.
    */
   void NotifyCtsTimeoutResetNow ();
-  void NotifyChangeAntennaModeNow (int mode);
   void SetNextAntennaMode (int mode);
 private:
   /**
@@ -446,6 +459,23 @@ private:
    * be granted
    */
   Time GetAccessGrantStart (void) const;
+  /**
+   * Recompute the part of the access grant start which does not
+   * depend on the antenna mode (rx, tx, ack/cts timeouts and
+   * switching). Called whenever one of those inputs changes.
+   */
+  void UpdateCommonAccessStart (void);
+  /**
+   * Recompute the busy/nav part of the access grant start of the
+   * given antenna mode.
+   *
+   * \param mode the antenna mode whose CCA busy or NAV changed
+   */
+  void UpdateModeAccessStart (int mode);
+  /**
+   * Recompute the common part and the part of every antenna mode.
+   */
+  void UpdateAccessGrantStart (void);
   /**
    * Return the time when the backoff procedure
    * started for the given DcfState.
@@ -489,26 +519,26 @@ private:
   States m_states;
   Time m_lastAckTimeoutEnd;
   Time m_lastCtsTimeoutEnd;
-  Time m_lastNavStart [WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-  Time m_lastNavDuration [WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
+  Time m_lastNavStart [WifiAntennaModel::MAX_ANTENNA_MODES];
+  Time m_lastNavDuration [WifiAntennaModel::MAX_ANTENNA_MODES];
   Time m_lastRxStart;
   Time m_lastRxDuration;
   bool m_lastRxReceivedOk;
   Time m_lastRxEnd;
   Time m_lastTxStart;
   Time m_lastTxDuration;
-  Time m_lastBusyStart [WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-  Time m_lastBusyDuration [WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
+  Time m_lastBusyStart [WifiAntennaModel::MAX_ANTENNA_MODES];
+  Time m_lastBusyDuration [WifiAntennaModel::MAX_ANTENNA_MODES];
   Time m_lastSwitchingStart;
   Time m_lastSwitchingDuration;
-  int m_antennaMode;
-  int m_nextAntennaMode;
+  Time m_commonAccessStart; //!< Latest rx/tx/timeout/switching end plus SIFS
+  Time m_modeAccessStart [WifiAntennaModel::MAX_ANTENNA_MODES]; //!< Latest busy/nav end plus SIFS
+  Ptr<WifiAntennaState> m_antennaState; //!< Shared with the antenna and the PHY
   bool m_rxing;
   Time m_eifsNoDifs;
-  EventId m_accessTimeout;
+  WifiLazyTimer m_accessTimeout;
   uint32_t m_slotTimeUs;
   Time m_sifs;
-  AntennaListener* m_antennaListener;
   PhyListener* m_phyListener;
   LowDcfListener* m_lowListener;
 };
@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "geography-oracle.h"
+#include "wifi-channel.h"
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/mobility-model.h"
+
+NS_LOG_COMPONENT_DEFINE ("GeographyOracle");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (GeographyOracle);
+
+TypeId
+GeographyOracle::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::GeographyOracle")
+    .SetParent<GeographyTable> ()
+    .AddConstructor<GeographyOracle> ()
+    ;
+  return tid;
+}
+
+GeographyOracle::GeographyOracle ()
+  : m_channel (0),
+    m_nScanned (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+GeographyOracle::~GeographyOracle ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+GeographyOracle::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_channel = 0;
+  m_mobilities.clear ();
+  GeographyTable::DoDispose ();
+}
+
+void
+GeographyOracle::SetChannel (WifiChannel *channel)
+{
+  NS_LOG_FUNCTION (this << channel);
+  m_channel = channel;
+  m_mobilities.clear ();
+  m_nScanned = 0;
+}
+
+Ptr<MobilityModel>
+GeographyOracle::Find (Mac48Address address)
+{
+  std::map<Mac48Address, Ptr<MobilityModel> >::const_iterator it = m_mobilities.find (address);
+  if (it != m_mobilities.end ())
+    {
+      return it->second;
+    }
+  if (m_channel == 0 || m_channel->GetNDevices () == m_nScanned)
+    {
+      return 0;
+    }
+  for (; m_nScanned < m_channel->GetNDevices (); m_nScanned++)
+    {
+      Ptr<NetDevice> device = m_channel->GetDevice (m_nScanned);
+      Ptr<MobilityModel> mobility = device->GetNode ()->GetObject<MobilityModel> ();
+      NS_LOG_DEBUG ("device " << m_nScanned << " is " << device->GetAddress ());
+      m_mobilities[Mac48Address::ConvertFrom (device->GetAddress ())] = mobility;
+    }
+  it = m_mobilities.find (address);
+  if (it == m_mobilities.end ())
+    {
+      return 0;
+    }
+  return it->second;
+}
+
+Angles
+GeographyOracle::GetAngle (Mac48Address address, const Vector &position, bool *existsAddress)
+{
+  NS_LOG_FUNCTION (this << address << position);
+  Ptr<MobilityModel> mobility = Find (address);
+  *existsAddress = mobility != 0;
+  if (mobility == 0)
+    {
+      return Angles ((double)0, (double)0);
+    }
+  return Angles (mobility->GetPosition (), position);
+}
+
+Vector
+GeographyOracle::GetDisplacement (Mac48Address address, const Vector &position, bool *existsAddress)
+{
+  NS_LOG_FUNCTION (this << address << position);
+  Ptr<MobilityModel> mobility = Find (address);
+  *existsAddress = mobility != 0;
+  if (mobility == 0)
+    {
+      return Vector (0, 0, 0);
+    }
+  Vector other = mobility->GetPosition ();
+  return Vector (other.x - position.x, other.y - position.y, other.z - position.z);
+}
+
+bool
+GeographyOracle::IsExistsAddress (Mac48Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+  return Find (address) != 0;
+}
+
+bool
+GeographyOracle::IsLearnedFromTags (void) const
+{
+  return false;
+}
+
+} // namespace ns3
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef GEOGRAPHY_ORACLE_H
+#define GEOGRAPHY_ORACLE_H
+
+#include <stdint.h>
+#include <map>
+#include "ns3/ptr.h"
+#include "geography-table.h"
+
+namespace ns3 {
+
+class WifiChannel;
+class MobilityModel;
+
+/**
+ * \ingroup wifi
+ * \brief geography table which knows the exact position of every node
+ *
+ * A single instance is shared by all the PHYs of a channel, in place
+ * of their own tables, when the GeographyOracle attribute of
+ * YansWifiChannel is set. Positions are read from the MobilityModel of
+ * the node of each device on the channel instead of being learned from
+ * geography tags, so the first exchange with a neighbour is steered
+ * like any other. Only CTS and ACK frames still carry a tag: they
+ * have no transmitter address for the oracle to look up, and the
+ * nodes overhearing them need the position of the sender to set their
+ * NAV in its direction.
+ *
+ * The address of each device is resolved the first time it is looked
+ * up; the devices are scanned again only when one was added to the
+ * channel since.
+ */
+class GeographyOracle : public GeographyTable
+{
+public:
+  static TypeId GetTypeId (void);
+
+  GeographyOracle ();
+  virtual ~GeographyOracle ();
+
+  /**
+   * \param channel the channel whose devices are located; it is not
+   * referenced, since it is expected to own the oracle
+   */
+  void SetChannel (WifiChannel *channel);
+
+  virtual Angles GetAngle (Mac48Address address, const Vector &position, bool *existsAddress);
+  virtual Vector GetDisplacement (Mac48Address address, const Vector &position, bool *existsAddress);
+  virtual bool IsExistsAddress (Mac48Address address);
+  virtual bool IsLearnedFromTags (void) const;
+
+private:
+  virtual void DoDispose (void);
+  /**
+   * \return the mobility model of the node with the given address, or
+   * 0 if there is none on the channel
+   */
+  Ptr<MobilityModel> Find (Mac48Address address);
+
+  WifiChannel *m_channel; //!< Not owned
+  std::map<Mac48Address, Ptr<MobilityModel> > m_mobilities; //!< By device address
+  uint32_t m_nScanned; //!< Number of channel devices in m_mobilities
+};
+
+} // namespace ns3
+
+#endif /* GEOGRAPHY_ORACLE_H */
@@ -4,7 +4,7 @@
  *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License version 2 as
-n * published by the Free Software Foundation;
+* published by the Free Software Foundation;
  *
  * This program is distributed in the hope that it will be useful,
  * but WITHOUT ANY WARRANTY; without even the implied warranty of
@@ -20,26 +20,106 @@ n * published by the Free Software Foundation;
 
 #include <vector>
 #include "ns3/log.h"
+#include "ns3/assert.h"
 #include "geography-table.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/mac48-address.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include "ns3/enum.h"
 
 NS_LOG_COMPONENT_DEFINE ("GeographyTable");
 
 namespace ns3 {
 
+// no entry, in the index and in the LRU list
+static const uint32_t NONE = 0xffffffff;
+static const uint32_t INITIAL_SLOTS = 16;
+
 TypeId
 GeographyTable::GetTypeId (void)
 {
   static TypeId tid = TypeId ("GeographyTable")
     .SetParent<Object> ()
     .AddConstructor<GeographyTable> ()
+    .AddAttribute ("EntryLifetime",
+                   "How long a position stays valid after its last update; zero means forever",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&GeographyTable::SetEntryLifetime,
+                                     &GeographyTable::GetEntryLifetime),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxEntries",
+                   "The largest number of neighbours kept, the least recently used being evicted; zero means no bound",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&GeographyTable::SetMaxEntries,
+                                         &GeographyTable::GetMaxEntries),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AdvertiseVelocity",
+                   "Whether the frames sent by this node carry its velocity along with its position",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&GeographyTable::SetAdvertiseVelocity,
+                                        &GeographyTable::GetAdvertiseVelocity),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxExtrapolation",
+                   "How long the position of a neighbour with a known velocity is extrapolated "
+                   "before it is treated as missing",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&GeographyTable::SetMaxExtrapolation,
+                                     &GeographyTable::GetMaxExtrapolation),
+                   MakeTimeChecker ())
+    .AddAttribute ("TagEncoding",
+                   "How the frames sent by this node encode its position",
+                   EnumValue (GeographyTag::DOUBLE),
+                   MakeEnumAccessor (&GeographyTable::SetTagEncoding,
+                                     &GeographyTable::GetTagEncoding),
+                   MakeEnumChecker (GeographyTag::DOUBLE, "Double",
+                                    GeographyTag::FLOAT, "Float",
+                                    GeographyTag::FIXED, "Fixed"))
+    .AddAttribute ("TagOrigin",
+                   "The origin of the Fixed encoding, which must be the same on all the nodes",
+                   VectorValue (Vector (0, 0, 0)),
+                   MakeVectorAccessor (&GeographyTable::SetTagOrigin,
+                                       &GeographyTable::GetTagOrigin),
+                   MakeVectorChecker ())
+    .AddAttribute ("TagResolution",
+                   "The step (m) of the Fixed encoding, which must be the same on all the nodes",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&GeographyTable::SetTagResolution,
+                                       &GeographyTable::GetTagResolution),
+                   MakeDoubleChecker<double> (1e-6))
+    .AddAttribute ("TagMovementThreshold",
+                   "The distance (m) this node must move before its frames carry its position again; "
+                   "zero means every frame",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&GeographyTable::SetTagMovementThreshold,
+                                       &GeographyTable::GetTagMovementThreshold),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("TagRefreshInterval",
+                   "The longest time without a frame carrying the position of this node "
+                   "when TagMovementThreshold is set",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&GeographyTable::SetTagRefreshInterval,
+                                     &GeographyTable::GetTagRefreshInterval),
+                   MakeTimeChecker ())
     ;
   return tid;
 }
 
 GeographyTable::GeographyTable ()
+  : m_size (0),
+    m_newest (NONE),
+    m_oldest (NONE),
+    m_lifetime (Seconds (0)),
+    m_maxEntries (0),
+    m_advertiseVelocity (false),
+    m_maxExtrapolation (Seconds (1)),
+    m_tagEncoding (GeographyTag::DOUBLE),
+    m_tagOrigin (Vector (0, 0, 0)),
+    m_tagResolution (0.01),
+    m_tagMovementThreshold (0),
+    m_tagRefreshInterval (Seconds (1))
 {
   InitItem();
 }
@@ -49,103 +129,451 @@ GeographyTable::~GeographyTable ()
   InitItem();
 }
 
-Angles
-GeographyTable::GetAngle(Mac48Address address, const Vector &position, bool *existsAddress)
+void
+GeographyTable::SetEntryLifetime (Time lifetime)
 {
-  NS_LOG_FUNCTION(this << address << position);
-  for(unsigned int i = 0; i < items.size(); i++)
+  NS_LOG_FUNCTION (this << lifetime);
+  m_lifetime = lifetime;
+}
+
+Time
+GeographyTable::GetEntryLifetime (void) const
+{
+  return m_lifetime;
+}
+
+void
+GeographyTable::SetMaxEntries (uint32_t maxEntries)
+{
+  NS_LOG_FUNCTION (this << maxEntries);
+  m_maxEntries = maxEntries;
+  while (m_maxEntries > 0 && m_size > m_maxEntries)
     {
-      if(items[i]->GetAddress() == address)
-	{
-	  *existsAddress = true;
-	  return Angles (items[i]->GetPosition (), position);
-	}
+      Erase (FindSlot (m_entries[m_oldest].key));
     }
-  *existsAddress = false;
-  return Angles ((double)0, (double)0);
 }
-  
+
+uint32_t
+GeographyTable::GetMaxEntries (void) const
+{
+  return m_maxEntries;
+}
+
 void
-GeographyTable::AddItem(Mac48Address address, const Vector &position)
+GeographyTable::SetAdvertiseVelocity (bool advertise)
 {
-  NS_LOG_FUNCTION(this << address << position);
-  items.push_back(new GeographyItem(address, position));
+  NS_LOG_FUNCTION (this << advertise);
+  m_advertiseVelocity = advertise;
 }
-  
+
+bool
+GeographyTable::GetAdvertiseVelocity (void) const
+{
+  return m_advertiseVelocity;
+}
+
 void
-GeographyTable::InitItem()
+GeographyTable::SetMaxExtrapolation (Time limit)
+{
+  NS_LOG_FUNCTION (this << limit);
+  m_maxExtrapolation = limit;
+}
+
+Time
+GeographyTable::GetMaxExtrapolation (void) const
+{
+  return m_maxExtrapolation;
+}
+
+void
+GeographyTable::SetTagEncoding (GeographyTag::Encoding encoding)
+{
+  NS_LOG_FUNCTION (this << encoding);
+  m_tagEncoding = encoding;
+}
+
+GeographyTag::Encoding
+GeographyTable::GetTagEncoding (void) const
+{
+  return m_tagEncoding;
+}
+
+void
+GeographyTable::SetTagOrigin (const Vector &origin)
+{
+  NS_LOG_FUNCTION (this << origin);
+  m_tagOrigin = origin;
+}
+
+Vector
+GeographyTable::GetTagOrigin (void) const
+{
+  return m_tagOrigin;
+}
+
+void
+GeographyTable::SetTagResolution (double resolution)
+{
+  NS_LOG_FUNCTION (this << resolution);
+  NS_ASSERT (resolution > 0);
+  m_tagResolution = resolution;
+}
+
+double
+GeographyTable::GetTagResolution (void) const
+{
+  return m_tagResolution;
+}
+
+void
+GeographyTable::ConfigureTag (GeographyTag &tag) const
+{
+  tag.SetEncoding (m_tagEncoding, m_tagOrigin, m_tagResolution);
+}
+
+void
+GeographyTable::SetTagMovementThreshold (double threshold)
+{
+  NS_LOG_FUNCTION (this << threshold);
+  m_tagMovementThreshold = threshold;
+}
+
+double
+GeographyTable::GetTagMovementThreshold (void) const
+{
+  return m_tagMovementThreshold;
+}
+
+void
+GeographyTable::SetTagRefreshInterval (Time interval)
+{
+  NS_LOG_FUNCTION (this << interval);
+  m_tagRefreshInterval = interval;
+}
+
+Time
+GeographyTable::GetTagRefreshInterval (void) const
+{
+  return m_tagRefreshInterval;
+}
+
+uint32_t
+GeographyTable::GetNEntries (void) const
 {
-  items.clear();
+  return m_size;
 }
+
+uint64_t
+GeographyTable::MakeKey (Mac48Address address)
+{
+  uint8_t buffer[6];
+  address.CopyTo (buffer);
+  uint64_t key = 0;
+  for (int i = 0; i < 6; i++)
+    {
+      key = (key << 8) | buffer[i];
+    }
+  return key;
+}
+
+static uint32_t
+GetHomeSlot (uint64_t key, uint32_t mask)
+{
+  return static_cast<uint32_t> ((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+uint32_t
+GeographyTable::FindSlot (uint64_t key) const
+{
+  // Fibonacci hashing followed by linear probing; the index is a
+  // power of two in size and never more than half full.
+  uint32_t mask = m_index.size () - 1;
+  uint32_t i = GetHomeSlot (key, mask);
+  while (m_index[i] != NONE && m_entries[m_index[i]].key != key)
+    {
+      i = (i + 1) & mask;
+    }
+  return i;
+}
+
 bool
-GeographyTable::IsExistsAddress(Mac48Address address)
+GeographyTable::IsExpired (const Entry &entry) const
 {
-  NS_LOG_FUNCTION(this);
-  for(unsigned int i = 0; i < items.size(); i++)
+  Time age = Simulator::Now () - entry.lastUpdate;
+  return (m_lifetime.IsStrictlyPositive () && age > m_lifetime)
+    || (entry.hasVelocity && age > m_maxExtrapolation);
+}
+
+Vector
+GeographyTable::GetCurrentPosition (const Entry &entry) const
+{
+  if (!entry.hasVelocity)
     {
-      NS_LOG_DEBUG(this << items[i]->GetAddress());
-      if(items[i]->GetAddress() == address)
-	{
-	  return true;
-	}
+      return entry.position;
     }
-  return false;
+  double age = (Simulator::Now () - entry.lastUpdate).GetSeconds ();
+  return Vector (entry.position.x + entry.velocity.x * age,
+                 entry.position.y + entry.velocity.y * age,
+                 entry.position.z + entry.velocity.z * age);
 }
+
 void
-GeographyTable::UpdatePosition(Mac48Address address,  const Vector &position)
+GeographyTable::Unlink (uint32_t e)
 {
-  NS_LOG_FUNCTION(this);
-  for(unsigned int i = 0; i < items.size(); i++)
+  Entry &entry = m_entries[e];
+  if (entry.newer != NONE)
     {
-      if(items[i]->GetAddress() == address)
-	{
-	  items[i]->SetPosition(position);
-	}
+      m_entries[entry.newer].older = entry.older;
     }
-}  
+  else
+    {
+      m_newest = entry.older;
+    }
+  if (entry.older != NONE)
+    {
+      m_entries[entry.older].newer = entry.newer;
+    }
+  else
+    {
+      m_oldest = entry.newer;
+    }
+}
+
 void
-GeographyTable::UpdateTable(Mac48Address address, const Vector &position)
+GeographyTable::LinkNewest (uint32_t e)
 {
-
-  NS_LOG_FUNCTION(this << address);
-  if(IsExistsAddress(address))
+  Entry &entry = m_entries[e];
+  entry.newer = NONE;
+  entry.older = m_newest;
+  if (m_newest != NONE)
     {
-      UpdatePosition(address, position);
+      m_entries[m_newest].newer = e;
     }
   else
     {
-      AddItem(address, position);
+      m_oldest = e;
     }
+  m_newest = e;
 }
 
+uint32_t
+GeographyTable::Lookup (Mac48Address address)
+{
+  if (m_size == 0)
+    {
+      return NONE;
+    }
+  uint32_t slot = FindSlot (MakeKey (address));
+  uint32_t e = m_index[slot];
+  if (e == NONE)
+    {
+      return NONE;
+    }
+  if (IsExpired (m_entries[e]))
+    {
+      NS_LOG_LOGIC ("entry of " << address << " expired");
+      Erase (slot);
+      return NONE;
+    }
+  if (e != m_newest)
+    {
+      Unlink (e);
+      LinkNewest (e);
+    }
+  return e;
+}
 
-  
-GeographyItem::GeographyItem (Mac48Address address, const Vector &position)
-  : m_address (address),
-    m_position (position)
+uint32_t
+GeographyTable::Insert (uint64_t key)
 {
+  if (m_maxEntries > 0 && m_size >= m_maxEntries)
+    {
+      NS_LOG_LOGIC ("evict the least recently used entry");
+      Erase (FindSlot (m_entries[m_oldest].key));
+    }
+  if (2 * (m_size + 1) > m_index.size ())
+    {
+      // purging expired entries may be enough; if it frees little,
+      // grow so that the next purge is far away.
+      RemoveExpired ();
+      if (4 * (m_size + 1) > m_index.size ())
+        {
+          Grow ();
+        }
+    }
+  uint32_t e;
+  if (m_free.empty ())
+    {
+      e = m_entries.size ();
+      m_entries.push_back (Entry ());
+    }
+  else
+    {
+      e = m_free.back ();
+      m_free.pop_back ();
+    }
+  m_entries[e].key = key;
+  m_index[FindSlot (key)] = e;
+  LinkNewest (e);
+  m_size++;
+  return e;
 }
 
-GeographyItem::~GeographyItem ()
+void
+GeographyTable::Erase (uint32_t slot)
 {
+  uint32_t e = m_index[slot];
+  NS_ASSERT (e != NONE);
+  Unlink (e);
+  m_free.push_back (e);
+  m_size--;
+
+  // backward shift deletion: move up the entries of the probe
+  // sequence which can no longer be reached through the hole.
+  uint32_t mask = m_index.size () - 1;
+  uint32_t hole = slot;
+  for (uint32_t j = (slot + 1) & mask; m_index[j] != NONE; j = (j + 1) & mask)
+    {
+      uint32_t home = GetHomeSlot (m_entries[m_index[j]].key, mask);
+      bool reachable = hole <= j
+        ? (home > hole && home <= j)
+        : (home > hole || home <= j);
+      if (!reachable)
+        {
+          m_index[hole] = m_index[j];
+          hole = j;
+        }
+    }
+  m_index[hole] = NONE;
 }
 
-Mac48Address
-GeographyItem::GetAddress()
+void
+GeographyTable::Grow (void)
 {
-  return m_address;
+  m_index.assign (m_index.empty () ? INITIAL_SLOTS : 2 * m_index.size (), NONE);
+  NS_LOG_DEBUG ("grow to " << m_index.size () << " slots");
+  for (uint32_t e = m_oldest; e != NONE; e = m_entries[e].newer)
+    {
+      m_index[FindSlot (m_entries[e].key)] = e;
+    }
 }
 
 void
-GeographyItem::SetPosition (const Vector &position)
+GeographyTable::RemoveExpired (void)
+{
+  uint32_t e = m_oldest;
+  while (e != NONE)
+    {
+      uint32_t next = m_entries[e].newer;
+      if (IsExpired (m_entries[e]))
+        {
+          Erase (FindSlot (m_entries[e].key));
+        }
+      e = next;
+    }
+}
+
+Angles
+GeographyTable::GetAngle(Mac48Address address, const Vector &position, bool *existsAddress)
 {
-  m_position = position;
+  NS_LOG_FUNCTION(this << address << position);
+  uint32_t e = Lookup (address);
+  if(e != NONE)
+    {
+      *existsAddress = true;
+      return Angles (GetCurrentPosition (m_entries[e]), position);
+    }
+  *existsAddress = false;
+  return Angles ((double)0, (double)0);
 }
 
 Vector
-GeographyItem::GetPosition ()
+GeographyTable::GetDisplacement(Mac48Address address, const Vector &position, bool *existsAddress)
+{
+  NS_LOG_FUNCTION(this << address << position);
+  uint32_t e = Lookup (address);
+  if(e != NONE)
+    {
+      *existsAddress = true;
+      Vector other = GetCurrentPosition (m_entries[e]);
+      return Vector (other.x - position.x, other.y - position.y, other.z - position.z);
+    }
+  *existsAddress = false;
+  return Vector (0, 0, 0);
+}
+  
+void
+GeographyTable::AddItem(Mac48Address address, const Vector &position)
+{
+  NS_LOG_FUNCTION(this << address << position);
+  UpdateTable (address, position);
+}
+  
+void
+GeographyTable::InitItem()
+{
+  m_index.clear ();
+  m_entries.clear ();
+  m_free.clear ();
+  m_size = 0;
+  m_newest = NONE;
+  m_oldest = NONE;
+}
+bool
+GeographyTable::IsExistsAddress(Mac48Address address)
+{
+  NS_LOG_FUNCTION(this << address);
+  return Lookup (address) != NONE;
+}
+
+bool
+GeographyTable::IsLearnedFromTags (void) const
+{
+  return true;
+}
+void
+GeographyTable::UpdatePosition(Mac48Address address,  const Vector &position)
+{
+  NS_LOG_FUNCTION(this);
+  uint32_t e = Lookup (address);
+  if(e != NONE)
+    {
+      m_entries[e].position = position;
+      m_entries[e].hasVelocity = false;
+      m_entries[e].lastUpdate = Simulator::Now ();
+    }
+}  
+uint32_t
+GeographyTable::Update (Mac48Address address, const Vector &position)
+{
+  uint32_t e = Lookup (address);
+  if(e == NONE)
+    {
+      e = Insert (MakeKey (address));
+    }
+  m_entries[e].position = position;
+  m_entries[e].lastUpdate = Simulator::Now ();
+  return e;
+}
+
+void
+GeographyTable::UpdateTable(Mac48Address address, const Vector &position)
+{
+
+  NS_LOG_FUNCTION(this << address);
+  uint32_t e = Update (address, position);
+  m_entries[e].hasVelocity = false;
+}
+
+void
+GeographyTable::UpdateTable(Mac48Address address, const Vector &position, const Vector &velocity)
 {
-  return m_position;
+  NS_LOG_FUNCTION(this << address << velocity);
+  uint32_t e = Update (address, position);
+  m_entries[e].velocity = velocity;
+  // a node standing still is known by its position alone, which does
+  // not go stale after MaxExtrapolation
+  m_entries[e].hasVelocity = velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
 }
 
 } // namespace ns3
@@ -26,44 +26,186 @@
 
 #include "ns3/mac48-address.h"
 #include "ns3/object.h"
+#include "ns3/nstime.h"
 #include "ns3/vector.h"
 #include "ns3/angles.h"
+#include "geography-tag.h"
 
 namespace ns3 {
 
-class GeographyItem
-{
-public:
-  ~GeographyItem();
-  GeographyItem (Mac48Address address, const Vector &position);
-  Mac48Address GetAddress (void);
-  void SetPosition (const Vector &position);
-  Vector GetPosition ();
-  
-private:
-  Mac48Address m_address;
-  Vector m_position;
-};
-
+/**
+ * \brief last known position of the neighbours of a node
+ *
+ * Entries live in a pool and are found through an open-addressing
+ * index keyed by the 48-bit address, so that lookups and updates take
+ * constant time whatever the number of neighbours, and no entry is
+ * allocated on its own. Each entry remembers when it was last
+ * updated: entries older than EntryLifetime are treated as missing,
+ * and once MaxEntries entries are stored, adding a new one evicts the
+ * least recently used.
+ *
+ * A position received with the velocity of the neighbour is
+ * extrapolated to the time of each lookup, for at most
+ * MaxExtrapolation; after that the entry is treated as missing, so
+ * that the MAC falls back to the omni mode rather than steer a beam
+ * at a guess.
+ */
 class GeographyTable : public Object
 {
 public:
   static TypeId GetTypeId (void);
-  Angles GetAngle(Mac48Address, const Vector &position, bool *existsAddress);
+  virtual Angles GetAngle(Mac48Address, const Vector &position, bool *existsAddress);
+  /**
+   * \param address the address of the other node
+   * \param position the position of this node
+   * \param existsAddress set to whether the address is in the table
+   * \return the last known position of address minus position, or a
+   * zero vector if the address is unknown
+   */
+  virtual Vector GetDisplacement(Mac48Address address, const Vector &position, bool *existsAddress);
   void AddItem(Mac48Address address, const Vector &position);
   void InitItem();
-  bool IsExistsAddress(Mac48Address address);
+  virtual bool IsExistsAddress(Mac48Address address);
   void UpdatePosition(Mac48Address address, const Vector &position);
   void UpdateTable(Mac48Address address, const Vector &position);
+  /**
+   * Same as UpdateTable (address, position), for a neighbour whose
+   * velocity is known. A zero velocity is the same as none: the
+   * position does not expire after MaxExtrapolation.
+   *
+   * \param address the address of the neighbour
+   * \param position the position of the neighbour
+   * \param velocity the velocity of the neighbour (m/s)
+   */
+  void UpdateTable(Mac48Address address, const Vector &position, const Vector &velocity);
+  /**
+   * \return true if the positions come from the geography tags of the
+   * frames received, false if the table knows them by other means and
+   * only the CTS and ACK frames, which have no transmitter address to
+   * look up, carry tags
+   */
+  virtual bool IsLearnedFromTags (void) const;
+
+  /**
+   * \param advertise whether the frames sent by this node carry its
+   * velocity along with its position
+   */
+  void SetAdvertiseVelocity (bool advertise);
+  bool GetAdvertiseVelocity (void) const;
+  /**
+   * \param limit how long after its last update the position of a
+   * neighbour with a known velocity is extrapolated
+   */
+  void SetMaxExtrapolation (Time limit);
+  Time GetMaxExtrapolation (void) const;
+
+  /**
+   * Set how the frames sent by this node encode its position. All the
+   * nodes must use the same origin and resolution.
+   *
+   * \param encoding the encoding of the geography tag
+   */
+  void SetTagEncoding (GeographyTag::Encoding encoding);
+  GeographyTag::Encoding GetTagEncoding (void) const;
+  void SetTagOrigin (const Vector &origin);
+  Vector GetTagOrigin (void) const;
+  void SetTagResolution (double resolution);
+  double GetTagResolution (void) const;
+  /**
+   * Apply the encoding, origin and resolution of this node to tag,
+   * before it is added to or removed from a packet.
+   *
+   * \param tag the geography tag
+   */
+  void ConfigureTag (GeographyTag &tag) const;
+  /**
+   * \param threshold the distance (m) this node must move before
+   * its frames carry its position again; zero means every frame
+   */
+  void SetTagMovementThreshold (double threshold);
+  double GetTagMovementThreshold (void) const;
+  /**
+   * \param interval the longest time without a frame carrying the
+   * position of this node when TagMovementThreshold is set, so that
+   * new neighbours learn it too
+   */
+  void SetTagRefreshInterval (Time interval);
+  Time GetTagRefreshInterval (void) const;
+
+  /**
+   * \param lifetime how long an entry stays valid after its last
+   * update; zero means forever
+   */
+  void SetEntryLifetime (Time lifetime);
+  Time GetEntryLifetime (void) const;
+  /**
+   * \param maxEntries the largest number of entries kept; zero means
+   * no bound
+   */
+  void SetMaxEntries (uint32_t maxEntries);
+  uint32_t GetMaxEntries (void) const;
+  /**
+   * \return the number of entries stored, including those which have
+   * expired but were not looked up since
+   */
+  uint32_t GetNEntries (void) const;
 
   GeographyTable();
-  ~GeographyTable();
+  virtual ~GeographyTable();
 private:
-  std::vector<GeographyItem*> items;
+  struct Entry
+  {
+    uint64_t key;
+    Vector position;
+    Vector velocity;
+    bool hasVelocity;
+    Time lastUpdate;
+    uint32_t newer; //!< LRU neighbour towards the most recently used
+    uint32_t older; //!< LRU neighbour towards the least recently used
+  };
+
+  static uint64_t MakeKey (Mac48Address address);
+  /**
+   * \return the index slot holding key, or the empty slot where it
+   * would be inserted
+   */
+  uint32_t FindSlot (uint64_t key) const;
+  /**
+   * \return the entry of the address if it is stored and not expired,
+   * after marking it as the most recently used; NONE otherwise
+   */
+  uint32_t Lookup (Mac48Address address);
+  uint32_t Insert (uint64_t key);
+  void Erase (uint32_t slot);
+  void Grow (void);
+  void RemoveExpired (void);
+  bool IsExpired (const Entry &entry) const;
+  /**
+   * \return the position of the entry, extrapolated to now
+   */
+  Vector GetCurrentPosition (const Entry &entry) const;
+  uint32_t Update (Mac48Address address, const Vector &position);
+  void Unlink (uint32_t e);
+  void LinkNewest (uint32_t e);
+
+  std::vector<uint32_t> m_index;  //!< open-addressing index of entries
+  std::vector<Entry> m_entries;   //!< entry pool
+  std::vector<uint32_t> m_free;   //!< unused entries of the pool
+  uint32_t m_size;
+  uint32_t m_newest;
+  uint32_t m_oldest;
+  Time m_lifetime;
+  uint32_t m_maxEntries;
+  bool m_advertiseVelocity;
+  Time m_maxExtrapolation;
+  GeographyTag::Encoding m_tagEncoding;
+  Vector m_tagOrigin;
+  double m_tagResolution;
+  double m_tagMovementThreshold;
+  Time m_tagRefreshInterval;
 };
 
 } // namespace ns3
 
 
 #endif /* GEOGRAPHY_TABLE_H */
-
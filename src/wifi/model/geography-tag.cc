@@ -22,10 +22,33 @@
 #include "ns3/tag.h"
 #include "ns3/double.h"
 #include "ns3/log.h"
+#include "ns3/assert.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
 
 namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (GeographyTag);
+
+static void
+WriteFloat (TagBuffer &i, double value)
+{
+  float f = static_cast<float> (value);
+  uint32_t bits;
+  std::memcpy (&bits, &f, sizeof (bits));
+  i.WriteU32 (bits);
+}
+
+static double
+ReadFloat (TagBuffer &i)
+{
+  uint32_t bits = i.ReadU32 ();
+  float f;
+  std::memcpy (&f, &bits, sizeof (f));
+  return f;
+}
+
 NS_LOG_COMPONENT_DEFINE ("GeographyTag");
 
 TypeId
@@ -58,40 +81,179 @@ GeographyTag::GetInstanceTypeId (void) const
 GeographyTag::GeographyTag ()
   : m_x (0),
     m_y (0),
-    m_z (0)
+    m_z (0),
+    m_hasVelocity (false),
+    m_vx (0),
+    m_vy (0),
+    m_encoding (DOUBLE),
+    m_origin (Vector (0, 0, 0)),
+    m_resolution (0.01)
 {
 }
 GeographyTag::GeographyTag (const Vector &position)
   : m_x (position.x),
     m_y (position.y),
-    m_z (position.z)
+    m_z (position.z),
+    m_hasVelocity (false),
+    m_vx (0),
+    m_vy (0),
+    m_encoding (DOUBLE),
+    m_origin (Vector (0, 0, 0)),
+    m_resolution (0.01)
 {
 }
 
+// A packet tag holds at most 20 bytes: a flag byte, which holds the
+// layout and whether a velocity follows, then the position and the
+// velocity, if any.
+static const uint8_t VELOCITY_FLAG = 0x4;
+static const uint8_t LAYOUT_MASK = 0x3;
+
+void
+GeographyTag::SetEncoding (Encoding encoding, const Vector &origin, double resolution)
+{
+  NS_ASSERT (resolution > 0);
+  m_encoding = encoding;
+  m_origin = origin;
+  m_resolution = resolution;
+}
+
+bool
+GeographyTag::FitsFixed (double value, double origin) const
+{
+  return std::fabs ((value - origin) / m_resolution) <= 32767;
+}
+
+void
+GeographyTag::WriteFixed (TagBuffer &i, double value, double origin) const
+{
+  double steps = (value - origin) / m_resolution;
+  steps = std::max (-32767.0, std::min (32767.0, steps));
+  i.WriteU16 (static_cast<uint16_t> (static_cast<int16_t> (steps < 0 ? steps - 0.5 : steps + 0.5)));
+}
+
+double
+GeographyTag::ReadFixed (TagBuffer &i, double origin) const
+{
+  return origin + static_cast<int16_t> (i.ReadU16 ()) * m_resolution;
+}
+
+GeographyTag::Encoding
+GeographyTag::GetLayout (void) const
+{
+  if (m_encoding == DOUBLE && m_hasVelocity)
+    {
+      return FLOAT;
+    }
+  if (m_encoding == FIXED
+      && !(FitsFixed (m_x, m_origin.x) && FitsFixed (m_y, m_origin.y) && FitsFixed (m_z, m_origin.z)
+           && (!m_hasVelocity || (FitsFixed (m_vx, 0) && FitsFixed (m_vy, 0)))))
+    {
+      return FLOAT;
+    }
+  return m_encoding;
+}
 
 uint32_t
 GeographyTag::GetSerializedSize (void) const
 {
-  return sizeof (double) + sizeof (double);
+  switch (GetLayout ())
+    {
+    case DOUBLE:
+      return 1 + 2 * sizeof (double);
+    case FLOAT:
+      // with a velocity, z is sent in 16 bits for the tag to fit in 20 bytes
+      return 1 + (m_hasVelocity ? 4 * sizeof (float) + sizeof (uint16_t) : 3 * sizeof (float));
+    default:
+      return 1 + (m_hasVelocity ? 5 : 3) * sizeof (uint16_t);
+    }
 }
 void
 GeographyTag::Serialize (TagBuffer i) const
 {
-  i.WriteDouble (m_x);
-  i.WriteDouble (m_y);
-  //  i.WriteDouble (m_z);
+  Encoding layout = GetLayout ();
+  i.WriteU8 (layout | (m_hasVelocity ? VELOCITY_FLAG : 0));
+  switch (layout)
+    {
+    case DOUBLE:
+      i.WriteDouble (m_x);
+      i.WriteDouble (m_y);
+      //  i.WriteDouble (m_z);
+      break;
+    case FLOAT:
+      WriteFloat (i, m_x);
+      WriteFloat (i, m_y);
+      if (m_hasVelocity)
+        {
+          WriteFloat (i, m_vx);
+          WriteFloat (i, m_vy);
+          WriteFixed (i, m_z, m_origin.z);
+        }
+      else
+        {
+          WriteFloat (i, m_z);
+        }
+      break;
+    default:
+      WriteFixed (i, m_x, m_origin.x);
+      WriteFixed (i, m_y, m_origin.y);
+      WriteFixed (i, m_z, m_origin.z);
+      if (m_hasVelocity)
+        {
+          WriteFixed (i, m_vx, 0);
+          WriteFixed (i, m_vy, 0);
+        }
+      break;
+    }
 }
 void
 GeographyTag::Deserialize (TagBuffer i)
 {
-  m_x = i.ReadDouble ();
-  m_y = i.ReadDouble ();
-  //  m_z = i.ReadDouble ();
+  uint8_t flags = i.ReadU8 ();
+  m_hasVelocity = (flags & VELOCITY_FLAG) != 0;
+  m_vx = 0;
+  m_vy = 0;
+  switch (flags & LAYOUT_MASK)
+    {
+    case DOUBLE:
+      m_x = i.ReadDouble ();
+      m_y = i.ReadDouble ();
+      //  m_z = i.ReadDouble ();
+      break;
+    case FLOAT:
+      m_x = ReadFloat (i);
+      m_y = ReadFloat (i);
+      if (m_hasVelocity)
+        {
+          m_vx = ReadFloat (i);
+          m_vy = ReadFloat (i);
+          m_z = ReadFixed (i, m_origin.z);
+        }
+      else
+        {
+          m_z = ReadFloat (i);
+        }
+      break;
+    default:
+      m_x = ReadFixed (i, m_origin.x);
+      m_y = ReadFixed (i, m_origin.y);
+      m_z = ReadFixed (i, m_origin.z);
+      if (m_hasVelocity)
+        {
+          m_vx = ReadFixed (i, 0);
+          m_vy = ReadFixed (i, 0);
+        }
+      break;
+    }
 }
 void
 GeographyTag::Print (std::ostream &os) const
 {
   os << "x=" << m_x << ", y= " << m_y << ", z=" << m_z;
+  if (m_hasVelocity)
+    {
+      os << ", vx=" << m_vx << ", vy=" << m_vy;
+    }
 }
 
 void
@@ -121,6 +283,23 @@ GeographyTag::Get (void) const
 {
   return Vector (m_x, m_y, m_z);
 }
+void
+GeographyTag::SetVelocity (const Vector &velocity)
+{
+  m_hasVelocity = true;
+  m_vx = velocity.x;
+  m_vy = velocity.y;
+}
+bool
+GeographyTag::HasVelocity (void) const
+{
+  return m_hasVelocity;
+}
+Vector
+GeographyTag::GetVelocity (void) const
+{
+  return Vector (m_vx, m_vy, 0);
+}
 
 
 }
@@ -12,6 +12,21 @@ class Tag;
 class GeographyTag : public Tag
 {
 public:
+  /**
+   * How the position is serialized.
+   */
+  enum Encoding
+  {
+    /** x and y in double precision, 16 bytes */
+    DOUBLE = 0,
+    /** x, y and z in single precision, 12 bytes */
+    FLOAT = 1,
+    /**
+     * x, y and z as 16-bit multiples of a resolution relative to an
+     * origin, 6 bytes; a position out of range is sent as FLOAT
+     */
+    FIXED = 2
+  };
   static TypeId GetTypeId (void);
   virtual TypeId GetInstanceTypeId (void) const;
 
@@ -62,10 +77,54 @@ public:
    * \return the node position.
    */
   Vector Get (void) const;
+  /**
+   * Make the tag carry the velocity of the node as well. The DOUBLE
+   * encoding then falls back to FLOAT, so that both fit in a packet
+   * tag; z is then sent in the 16-bit steps of the FIXED encoding,
+   * saturated at the ends of its range.
+   *
+   * \param velocity the velocity of the node (m/s)
+   */
+  void SetVelocity (const Vector &velocity);
+  /**
+   * \return true if the tag carries a velocity
+   */
+  bool HasVelocity (void) const;
+  /**
+   * \return the node velocity, zero if the tag carries none
+   */
+  Vector GetVelocity (void) const;
+  /**
+   * Select the encoding of the position. The receiving tag must be
+   * given the same origin and resolution to decode FIXED; the
+   * encoding itself travels with the tag.
+   *
+   * \param encoding the encoding to serialize with
+   * \param origin the origin of the FIXED encoding
+   * \param resolution the step (m) of the FIXED encoding; velocities
+   * use the same step per second
+   */
+  void SetEncoding (Encoding encoding, const Vector &origin, double resolution);
 private:
+  /**
+   * \return the encoding actually used to serialize, i.e., FLOAT when
+   * the velocity does not fit with DOUBLE or the position is out of the
+   * range of FIXED
+   */
+  Encoding GetLayout (void) const;
+  bool FitsFixed (double value, double origin) const;
+  void WriteFixed (TagBuffer &i, double value, double origin) const;
+  double ReadFixed (TagBuffer &i, double origin) const;
+
   double m_x;
   double m_y;
   double m_z;
+  bool m_hasVelocity;
+  double m_vx;
+  double m_vy;
+  Encoding m_encoding;
+  Vector m_origin;
+  double m_resolution;
 };
 
 
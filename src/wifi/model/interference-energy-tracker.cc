@@ -0,0 +1,329 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "interference-energy-tracker.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("InterferenceEnergyTracker");
+
+namespace ns3 {
+
+static const uint32_t NIL = 0xffffffff;
+
+InterferenceEnergyTracker::InterferenceEnergyTracker ()
+  : m_root (NIL),
+    m_nPending (0),
+    m_random (2463534242U),
+    m_nModes (0)
+{
+}
+
+uint32_t
+InterferenceEnergyTracker::NextPriority (void)
+{
+  // xorshift: the priorities only have to look random to keep the
+  // treap balanced, and must not consume the simulation's streams.
+  m_random ^= m_random << 13;
+  m_random ^= m_random >> 17;
+  m_random ^= m_random << 5;
+  return m_random;
+}
+
+bool
+InterferenceEnergyTracker::IsBefore (const Node &node, Time time, uint64_t seq) const
+{
+  return node.time < time || (node.time == time && node.seq < seq);
+}
+
+template <int N>
+void
+InterferenceEnergyTracker::UpdateModes (Node &node, const Node *left, const Node *right, uint32_t nModes)
+{
+  // N is the number of modes when it is one of the common sizes, so
+  // that the loop is unrolled, and 0 otherwise
+  const int count = N > 0 ? N : static_cast<int> (nModes);
+  const PerModePower &delta = node.delta;
+  for (int k = 0; k < count; k++)
+    {
+      double before = left == 0 ? 0.0 : left->sum[k];
+      double through = before + delta[k];
+      double minPrefix = through;
+      if (left != 0)
+        {
+          minPrefix = std::min (minPrefix, left->minPrefix[k]);
+        }
+      if (right != 0)
+        {
+          minPrefix = std::min (minPrefix, through + right->minPrefix[k]);
+        }
+      node.sum[k] = right == 0 ? through : through + right->sum[k];
+      node.minPrefix[k] = minPrefix;
+    }
+}
+
+void
+InterferenceEnergyTracker::Update (uint32_t n)
+{
+  Node &node = m_nodes[n];
+  const Node *left = node.left == NIL ? 0 : &m_nodes[node.left];
+  const Node *right = node.right == NIL ? 0 : &m_nodes[node.right];
+  node.sum.Extend (m_nModes);
+  node.minPrefix.Extend (m_nModes);
+  switch (m_nModes)
+    {
+    case 1: UpdateModes<1> (node, left, right, m_nModes); break;
+    case 5: UpdateModes<5> (node, left, right, m_nModes); break;
+    case 9: UpdateModes<9> (node, left, right, m_nModes); break;
+    case 17: UpdateModes<17> (node, left, right, m_nModes); break;
+    default: UpdateModes<0> (node, left, right, m_nModes); break;
+    }
+}
+
+void
+InterferenceEnergyTracker::Split (uint32_t n, Time time, uint64_t seq, uint32_t &left, uint32_t &right)
+{
+  if (n == NIL)
+    {
+      left = NIL;
+      right = NIL;
+      return;
+    }
+  Node &node = m_nodes[n];
+  if (IsBefore (node, time, seq))
+    {
+      Split (node.right, time, seq, node.right, right);
+      left = n;
+    }
+  else
+    {
+      Split (node.left, time, seq, left, node.left);
+      right = n;
+    }
+  Update (n);
+}
+
+uint32_t
+InterferenceEnergyTracker::Merge (uint32_t left, uint32_t right)
+{
+  if (left == NIL)
+    {
+      return right;
+    }
+  if (right == NIL)
+    {
+      return left;
+    }
+  if (m_nodes[left].priority > m_nodes[right].priority)
+    {
+      uint32_t merged = Merge (m_nodes[left].right, right);
+      m_nodes[left].right = merged;
+      Update (left);
+      return left;
+    }
+  uint32_t merged = Merge (left, m_nodes[right].left);
+  m_nodes[right].left = merged;
+  Update (right);
+  return right;
+}
+
+void
+InterferenceEnergyTracker::Release (uint32_t n)
+{
+  if (n == NIL)
+    {
+      return;
+    }
+  Release (m_nodes[n].left);
+  Release (m_nodes[n].right);
+  m_free.push_back (n);
+  m_nPending--;
+}
+
+void
+InterferenceEnergyTracker::Add (Time time, uint64_t seq, const PerModePower &delta)
+{
+  uint32_t n;
+  if (m_free.empty ())
+    {
+      n = m_nodes.size ();
+      m_nodes.push_back (Node ());
+    }
+  else
+    {
+      n = m_free.back ();
+      m_free.pop_back ();
+    }
+  Node &node = m_nodes[n];
+  node.time = time;
+  node.seq = seq;
+  node.priority = NextPriority ();
+  node.left = NIL;
+  node.right = NIL;
+  node.delta = delta;
+  // the sums of the existing nodes need not be extended: the modes
+  // they lack are zero all along
+  m_nModes = std::max (m_nModes, delta.GetNModes ());
+  Update (n);
+  m_nPending++;
+
+  uint32_t left, right;
+  Split (m_root, time, seq, left, right);
+  m_root = Merge (Merge (left, n), right);
+}
+
+void
+InterferenceEnergyTracker::Clear (void)
+{
+  m_nodes.clear ();
+  m_free.clear ();
+  m_root = NIL;
+  m_nPending = 0;
+  m_nModes = 0;
+  m_energyW = PerModePower ();
+}
+
+void
+InterferenceEnergyTracker::Advance (Time now)
+{
+  uint32_t past, future;
+  Split (m_root, now, 0, past, future);
+  if (past != NIL)
+    {
+      m_energyW += m_nodes[past].sum;
+      Release (past);
+    }
+  m_root = future;
+}
+
+uint32_t
+InterferenceEnergyTracker::Find (uint32_t n, PerModePower offset, uint32_t modes, uint32_t nModes,
+                                 double energyW, Time now, Time durations[]) const
+{
+  if (n == NIL)
+    {
+      return 0;
+    }
+  const Node &node = m_nodes[n];
+  uint32_t active = 0;
+  for (uint32_t k = 0; k < nModes; k++)
+    {
+      if ((modes & (1U << k)) && offset[k] + node.minPrefix[k] < energyW)
+        {
+          active |= 1U << k;
+        }
+    }
+  if (active == 0)
+    {
+      return 0;
+    }
+  uint32_t found = Find (node.left, offset, active, nModes, energyW, now, durations);
+  uint32_t right = 0;
+  for (uint32_t k = 0; k < nModes; k++)
+    {
+      if (!(active & (1U << k)) || (found & (1U << k)))
+        {
+          continue;
+        }
+      if (node.left != NIL)
+        {
+          offset[k] += m_nodes[node.left].sum[k];
+        }
+      offset[k] += node.delta[k];
+      if (offset[k] < energyW)
+        {
+          durations[k] = node.time - now;
+          found |= 1U << k;
+        }
+      else
+        {
+          right |= 1U << k;
+        }
+    }
+  if (right != 0)
+    {
+      found |= Find (node.right, offset, right, nModes, energyW, now, durations);
+    }
+  return found;
+}
+
+Time
+InterferenceEnergyTracker::GetLastTime (void) const
+{
+  uint32_t n = m_root;
+  while (m_nodes[n].right != NIL)
+    {
+      n = m_nodes[n].right;
+    }
+  return m_nodes[n].time;
+}
+
+Time
+InterferenceEnergyTracker::GetEnergyDuration (Time now, double energyW, int mode)
+{
+  NS_LOG_FUNCTION (this << now << energyW << mode);
+  Advance (now);
+  if (m_root == NIL)
+    {
+      return Seconds (0);
+    }
+  Time durations[WifiAntennaModel::MAX_ANTENNA_MODES];
+  if (Find (m_root, m_energyW, 1U << mode, mode + 1, energyW, now, durations) == 0)
+    {
+      // the energy never drops below the threshold while any change
+      // is pending: report the time of the last one.
+      return GetLastTime () - now;
+    }
+  return durations[mode];
+}
+
+void
+InterferenceEnergyTracker::GetEnergyDurations (Time now, double energyW, uint32_t nModes,
+                                               Time durations[WifiAntennaModel::MAX_ANTENNA_MODES])
+{
+  NS_LOG_FUNCTION (this << now << energyW << nModes);
+  NS_ASSERT (nModes <= static_cast<uint32_t> (WifiAntennaModel::MAX_ANTENNA_MODES));
+  Advance (now);
+  if (m_root == NIL)
+    {
+      for (uint32_t k = 0; k < nModes; k++)
+        {
+          durations[k] = Seconds (0);
+        }
+      return;
+    }
+  uint32_t all = (1U << nModes) - 1;
+  uint32_t found = Find (m_root, m_energyW, all, nModes, energyW, now, durations);
+  if (found != all)
+    {
+      Time last = GetLastTime () - now;
+      for (uint32_t k = 0; k < nModes; k++)
+        {
+          if (!(found & (1U << k)))
+            {
+              durations[k] = last;
+            }
+        }
+    }
+}
+
+uint32_t
+InterferenceEnergyTracker::GetNPending (void) const
+{
+  return m_nPending;
+}
+
+} // namespace ns3
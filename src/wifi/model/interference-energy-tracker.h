@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INTERFERENCE_ENERGY_TRACKER_H
+#define INTERFERENCE_ENERGY_TRACKER_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/nstime.h"
+#include "ns3/wifi-antenna-model.h"
+#include "per-mode-power.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ * \brief running sum of the received energy of each antenna mode
+ *
+ * Changes which lie in the past are folded into a per-mode running
+ * sum the first time a query is made after them. The remaining,
+ * future changes are kept in a treap ordered by (time, sequence)
+ * whose nodes store the per-mode sum and minimum prefix sum of their
+ * subtree. "When does the energy of mode k first drop below X" is
+ * then answered by a single descent of the tree, and the same
+ * question for every mode by one traversal which visits the union
+ * of those descents. Nodes live in a pool, so a steady state of
+ * additions and queries does not allocate. The work per node is
+ * proportional to the number of antenna modes of the changes.
+ */
+class InterferenceEnergyTracker
+{
+public:
+  InterferenceEnergyTracker ();
+
+  /**
+   * Record a change of the received energy.
+   *
+   * \param time the time of the change
+   * \param seq the order of the change among those of the same time
+   * \param delta the change of each antenna mode (W)
+   */
+  void Add (Time time, uint64_t seq, const PerModePower &delta);
+  /**
+   * Forget every change and reset the running sums to zero.
+   */
+  void Clear (void);
+  /**
+   * Fold every change which lies before the given time into the
+   * running sums. Queries do this themselves; calling it on every
+   * addition keeps the tree bounded when no query is made.
+   *
+   * \param now the current time
+   */
+  void Advance (Time now);
+
+  /**
+   * \param now the current time
+   * \param energyW the minimum energy (W) requested
+   * \param mode the antenna mode
+   * \returns the expected amount of time the observed energy of
+   *          the mode will be higher than the requested threshold.
+   */
+  Time GetEnergyDuration (Time now, double energyW, int mode);
+  /**
+   * Same as GetEnergyDuration for every antenna mode at once.
+   *
+   * \param now the current time
+   * \param energyW the minimum energy (W) requested
+   * \param nModes the number of antenna modes to answer for
+   * \param durations set to the duration of each of the nModes
+   *        first antenna modes
+   */
+  void GetEnergyDurations (Time now, double energyW, uint32_t nModes,
+                           Time durations[WifiAntennaModel::MAX_ANTENNA_MODES]);
+  /**
+   * \return the number of changes which are not yet folded
+   */
+  uint32_t GetNPending (void) const;
+
+private:
+  struct Node
+  {
+    Time time;
+    uint64_t seq;
+    uint32_t priority;
+    uint32_t left;
+    uint32_t right;
+    PerModePower delta;
+    PerModePower sum;
+    PerModePower minPrefix;
+  };
+
+  bool IsBefore (const Node &node, Time time, uint64_t seq) const;
+  void Update (uint32_t n);
+  void Split (uint32_t n, Time time, uint64_t seq, uint32_t &left, uint32_t &right);
+  uint32_t Merge (uint32_t left, uint32_t right);
+  void Release (uint32_t n);
+  uint32_t Find (uint32_t n, PerModePower offset, uint32_t modes, uint32_t nModes,
+                 double energyW, Time now, Time durations[]) const;
+  Time GetLastTime (void) const;
+  uint32_t NextPriority (void);
+  template <int N>
+  static void UpdateModes (Node &node, const Node *left, const Node *right, uint32_t nModes);
+
+  std::vector<Node> m_nodes;
+  std::vector<uint32_t> m_free;
+  uint32_t m_root;
+  uint32_t m_nPending;
+  uint32_t m_random;
+  uint32_t m_nModes;      //!< the largest number of modes of any change
+  PerModePower m_energyW; //!< sum of the folded changes
+};
+
+} // namespace ns3
+
+#endif /* INTERFERENCE_ENERGY_TRACKER_H */
@@ -22,53 +22,27 @@
 #include "error-rate-model.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
-#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE ("InterferenceHelper");
 
 namespace ns3 {
 
-class AntennaListenerInterferenceHelper : public ns3::WifiAntennaListener
-{
-public:
-  /**
-   * Create a AntennaListener for the given InterferenceHelper.
-   *
-   * \param state
-   */
-  AntennaListenerInterferenceHelper (ns3::InterferenceHelper *interference)
-    : m_interference (interference)
-  {
-  }
-  virtual ~AntennaListenerInterferenceHelper ()
-  {
-  }
-  virtual void NotifyChangeAntennaMode (int mode)
-  {
-    m_interference->NotifyChangeAntennaModeNow (mode);
-  }
-private:
-  ns3::InterferenceHelper *m_interference;  //!< InterferenceHelper to forward events to
-};
-
 /****************************************************************
  *       Phy event class
  ****************************************************************/
 
 InterferenceHelper::Event::Event (uint32_t size, WifiMode payloadMode,
                                   enum WifiPreamble preamble,
-                                  Time duration, double rxPower[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES],
+                                  Time duration, const PerModePower &rxPower,
                                   WifiTxVector txVector)
   : m_size (size),
     m_payloadMode (payloadMode),
     m_preamble (preamble),
     m_startTime (Simulator::Now ()),
     m_endTime (m_startTime + duration),
+    m_rxPowerW (rxPower),
     m_txVector (txVector)
 {
-  for(int i = 0; i < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
-    m_rxPowerW [i] =  rxPower [i];
-  }
 }
 InterferenceHelper::Event::~Event ()
 {
@@ -94,8 +68,8 @@ InterferenceHelper::Event::GetRxPowerW (int mode) const
 {
   return m_rxPowerW [mode];
 }
-double*
-InterferenceHelper::Event::GetAllRxPowerW (void)
+const PerModePower &
+InterferenceHelper::Event::GetAllRxPowerW (void) const
 {
   return m_rxPowerW;
 }
@@ -127,13 +101,11 @@ InterferenceHelper::Event::GetTxVector (void) const
  *       short period of time.
  ****************************************************************/
 
-InterferenceHelper::NiChange::NiChange (Time time, double* delta)
-  : m_time (time)
+InterferenceHelper::NiChange::NiChange (Time time, const PerModePower &delta, uint64_t seq)
+  : m_time (time),
+    m_delta (delta),
+    m_seq (seq)
 {
-  for(int i = 0; i < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
-    m_delta [i] = delta [i];
-    NS_LOG_DEBUG ("ddd" << m_delta [i]);
-  }
 }
 Time
 InterferenceHelper::NiChange::GetTime (void) const
@@ -145,15 +117,19 @@ InterferenceHelper::NiChange::GetDelta (int mode) const
 {
   return m_delta [mode];
 }
-double*
-InterferenceHelper::NiChange::GetDelta ()
+const PerModePower &
+InterferenceHelper::NiChange::GetDelta (void) const
 {
   return m_delta;
 }
 bool
 InterferenceHelper::NiChange::operator < (const InterferenceHelper::NiChange& o) const
 {
-  return (m_time < o.m_time);
+  if (m_time != o.m_time)
+    {
+      return m_time < o.m_time;
+    }
+  return m_seq < o.m_seq;
 }
 
 /****************************************************************
@@ -162,10 +138,10 @@ InterferenceHelper::NiChange::operator < (const InterferenceHelper::NiChange& o)
 
 InterferenceHelper::InterferenceHelper ()
   : m_errorRateModel (0),
-    m_firstPower (0.0),
+    m_nextSeq (0),
+    m_horizon (MilliSeconds (10)),
     m_rxing (false),
-    m_antennaMode (0),
-    m_antennaListener (0)
+    m_antennaState (Create<WifiAntennaState> ())
 {
 }
 InterferenceHelper::~InterferenceHelper ()
@@ -177,7 +153,7 @@ InterferenceHelper::~InterferenceHelper ()
 Ptr<InterferenceHelper::Event>
 InterferenceHelper::Add (uint32_t size, WifiMode payloadMode,
                          enum WifiPreamble preamble,
-                         Time duration, double rxPowerW[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES],
+                         Time duration, const PerModePower &rxPowerW,
                          WifiTxVector txVector)
 {
   Ptr<InterferenceHelper::Event> event;
@@ -205,6 +181,24 @@ InterferenceHelper::GetNoiseFigure (void) const
   return m_noiseFigure;
 }
 
+void
+InterferenceHelper::SetHorizon (Time horizon)
+{
+  m_horizon = horizon;
+}
+
+Time
+InterferenceHelper::GetHorizon (void) const
+{
+  return m_horizon;
+}
+
+uint32_t
+InterferenceHelper::GetNPendingChanges (void) const
+{
+  return m_niChanges.size ();
+}
+
 void
 InterferenceHelper::SetErrorRateModel (Ptr<ErrorRateModel> rate)
 {
@@ -220,53 +214,28 @@ InterferenceHelper::GetErrorRateModel (void) const
 Time
 InterferenceHelper::GetEnergyDuration (double energyW)
 {
-  Time now = Simulator::Now ();
-  double noiseInterferenceW = 0.0;
-  Time end = now;
-  noiseInterferenceW = m_firstPower;
-  for (NiChanges::const_iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
-    {
-      noiseInterferenceW += i->GetDelta (m_antennaMode);
-      end = i->GetTime ();
-      if (end < now)
-        {
-          continue;
-        }
-      if (noiseInterferenceW < energyW)
-        {
-          break;
-        }
-    }
-  return end > now ? end - now : MicroSeconds (0);
+  return GetEnergyDuration (energyW, m_antennaState->mode);
+}
+
+Time
+InterferenceHelper::GetEnergyDuration (double energyW, int mode)
+{
+  return m_energyTracker.GetEnergyDuration (Simulator::Now (), energyW, mode);
 }
 
 void
-InterferenceHelper::AppendEvent (Ptr<InterferenceHelper::Event> event)
+InterferenceHelper::GetEnergyDurations (double energyW, uint32_t nModes,
+                                        Time durations[WifiAntennaModel::MAX_ANTENNA_MODES])
 {
-  Time now = Simulator::Now ();
-  /*
-  if (!m_rxing)
-    {
-      NiChanges::iterator nowIterator = GetPosition (now);
-      for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-        {
-          m_firstPower += i->GetDelta (m_antennaMode);
-        }
-      m_niChanges.erase (m_niChanges.begin (), nowIterator);
-      m_niChanges.insert (m_niChanges.begin (), NiChange (event->GetStartTime (), event->GetAllRxPowerW ()));
-    }
-  else
-    {
-      AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetAllRxPowerW ()));
-    }
-  */
-  AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetAllRxPowerW ()));
-  double rxPowerW[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-  for(int i = 0; i < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
-    rxPowerW[i] = -event->GetAllRxPowerW ()[i];
-  }
-  AddNiChangeEvent (NiChange (event->GetEndTime (), rxPowerW));
+  m_energyTracker.GetEnergyDurations (Simulator::Now (), energyW, nModes, durations);
+}
 
+void
+InterferenceHelper::AppendEvent (Ptr<InterferenceHelper::Event> event)
+{
+  event->m_startChange = AddNiChangeEvent (event->GetStartTime (), event->GetAllRxPowerW ());
+  event->m_endChange = AddNiChangeEvent (event->GetEndTime (), -event->GetAllRxPowerW ());
+  PruneNiChanges ();
 }
 
 
@@ -288,24 +257,17 @@ InterferenceHelper::CalculateSnr (double signal, double noiseInterference, WifiM
 double
 InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event> event, NiChanges *ni) const
 {
-  double noiseInterference = m_firstPower;
+  double noiseInterference = m_firstPower[m_antennaState->mode];
   NS_ASSERT (m_rxing);
-  for (NiChanges::const_iterator i = m_niChanges.begin () + 1; i != m_niChanges.end (); i++)
+  NS_ASSERT (m_niChanges.begin () == event->m_startChange);
+  NiTimeline::const_iterator i = event->m_startChange;
+  for (i++; i != event->m_endChange; i++)
     {
-      if ((event->GetEndTime () == i->GetTime ()) && event->GetRxPowerW (m_antennaMode) == -i->GetDelta (m_antennaMode))
-        {
-          break;
-        }
       ni->push_back (*i);
     }
-  double noise[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-  double zero [WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-  for(int i = 0; i <WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
-    noise[i] = noiseInterference;
-    zero[i] = 0;
-  }
-  ni->insert (ni->begin (), NiChange (event->GetStartTime (), noise));
-  ni->push_back (NiChange (event->GetEndTime (), zero));
+  // only the current mode of the snapshot is read
+  ni->insert (ni->begin (), NiChange (event->GetStartTime (), PerModePower (m_antennaState->mode + 1, noiseInterference)));
+  ni->push_back (NiChange (event->GetEndTime (), PerModePower ()));
   return noiseInterference;
 }
 
@@ -341,8 +303,8 @@ InterferenceHelper::CalculatePer (Ptr<const InterferenceHelper::Event> event, Ni
   Time plcpHsigHeaderStart=plcpHeaderStart+ MicroSeconds (WifiPhy::GetPlcpHeaderDurationMicroSeconds (payloadMode, preamble));//packet start time+ preamble+L SIG
   Time plcpHtTrainingSymbolsStart = plcpHsigHeaderStart + MicroSeconds (WifiPhy::GetPlcpHtSigHeaderDurationMicroSeconds (payloadMode, preamble));//packet start time+ preamble+L SIG+HT SIG
   Time plcpPayloadStart =plcpHtTrainingSymbolsStart + MicroSeconds (WifiPhy::GetPlcpHtTrainingSymbolDurationMicroSeconds (payloadMode, preamble,event->GetTxVector())); //packet start time+ preamble+L SIG+HT SIG+Training
-  double noiseInterferenceW = (*j).GetDelta (m_antennaMode);
-  double powerW = event->GetRxPowerW (m_antennaMode);
+  double noiseInterferenceW = (*j).GetDelta (m_antennaState->mode);
+  double powerW = event->GetRxPowerW (m_antennaState->mode);
     j++;
   while (ni->end () != j)
     {
@@ -584,7 +546,7 @@ InterferenceHelper::CalculatePer (Ptr<const InterferenceHelper::Event> event, Ni
             }
         }
 
-      noiseInterferenceW += (*j).GetDelta (m_antennaMode);
+      noiseInterferenceW += (*j).GetDelta (m_antennaState->mode);
       previous = (*j).GetTime ();
       j++;
     }
@@ -597,113 +559,19 @@ InterferenceHelper::CalculatePer (Ptr<const InterferenceHelper::Event> event, Ni
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculateSnrPer (Ptr<InterferenceHelper::Event> event)
 {
-  NS_LOG_DEBUG ("*******************************************");
-  NS_LOG_DEBUG ("firstPowerr=" << m_firstPower);
-  NS_LOG_DEBUG ("event rxpower=" << event->GetRxPowerW (m_antennaMode) <<
+  NS_LOG_FUNCTION (this << event);
+  NS_LOG_DEBUG ("event rxpower=" << event->GetRxPowerW (m_antennaState->mode) <<
                 ",start time=" << event->GetStartTime () <<
                 ",end time=" << event->GetEndTime ());
-  NS_LOG_DEBUG ("*******************************************");
-  for (NiChanges::iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
-    {
-      NS_LOG_DEBUG ("time=" << i->GetTime() << ", deleta=" << i->GetDelta (m_antennaMode));
-    }
-  NS_LOG_DEBUG ("*******************************************");
-
-  // separate
-  Time start = event->GetStartTime();
-  Time end = event->GetEndTime();
-  
-  NiChanges::iterator startIterator = GetEventPosition (event);
-  NiChanges::iterator endIterator = GetEventEndPosition (event);
 
-  std::vector<Time> Vtime;
-  std::vector<double*> Vdb;
-
-  for (NiChanges::iterator i = m_niChanges.begin (); i != endIterator; i++)
-    {
-      if(i == startIterator || i == endIterator){continue;}
-      if(i->GetDelta (0) < 0){continue;}
-
-      NiChanges::iterator j = i;
-      for (; j != m_niChanges.end (); j++)
-        {
-          NS_LOG_DEBUG ("[i]: "<< i->GetTime () << " [j]: " << j->GetTime ());
-          int k;
-          for(k = 0; k < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; k++){
-            NS_LOG_DEBUG ("[i]: "<< i->GetDelta (k) << " [j]: " << -j->GetDelta (k));
-            if(i->GetDelta (k) != -j->GetDelta (k))
-              {
-                break;
-              }
-          }
-          if(k == WifiAntennaModel::NUMBER_OF_ANTENNA_MODES){
-            NS_LOG_DEBUG ("[i]: "<< i->GetTime () << " [j]: " << j->GetTime ());
-            break;
-          }
-        }
-
-      NS_LOG_INFO ("i: " << i->GetTime () << ", start: " << startIterator->GetTime () <<
-        "j: " << j->GetTime () << ", end: " << endIterator->GetTime ());
-      if(i->GetTime () >= startIterator->GetTime () && i->GetTime () < endIterator->GetTime () && j->GetTime () > endIterator->GetTime ()){
-        NS_LOG_DEBUG("[1]i: " << i->GetDelta (m_antennaMode) << " j:" << j->GetDelta (m_antennaMode));
-        //        AddNiChangeEvent (NiChange (end - NanoSeconds (1), j->GetDelta ()));
-        //        AddNiChangeEvent (NiChange (end + NanoSeconds (1), i->GetDelta ()));
-        double *rxPowerDbmi = new double[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-        double *rxPowerDbmj = new double[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-        for(int k = 0; k < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; k++){
-          rxPowerDbmi [k] = i->GetDelta (k);
-          rxPowerDbmj [k] = j->GetDelta (k);
-        }
-        Vtime.push_back (end - NanoSeconds (1));
-        Vdb.push_back (rxPowerDbmj);
-        Vtime.push_back (end + NanoSeconds (1));
-        Vdb.push_back (rxPowerDbmi);
-      }else if(i->GetTime () <= startIterator->GetTime () && j->GetTime () > endIterator->GetTime ()){
-        NS_LOG_DEBUG("[2]i: " << i->GetDelta (m_antennaMode) << " j:" << j->GetDelta (m_antennaMode));
-        double *rxPowerDbmi = new double[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-        double *rxPowerDbmj = new double[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-        for(int k = 0; k < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; k++){
-          rxPowerDbmi [k] = i->GetDelta (k);
-          rxPowerDbmj [k] = j->GetDelta (k);
-        }
-        Vtime.push_back (end + NanoSeconds (1));
-        Vdb.push_back (rxPowerDbmi);
-        Vtime.push_back (end - NanoSeconds (1));
-        Vdb.push_back (rxPowerDbmj);
-      }
-    }
-
-  for (unsigned int i = 0; i < Vtime.size (); i++){
-    AddNiChangeEvent (NiChange (Vtime [i], Vdb [i]));
-  }
-
-  // sum noise
-  NiChanges::iterator nowIterator = GetPosition (start);
-  if(m_niChanges.begin() != nowIterator)
-    {
-      nowIterator--;
-    }
-  for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-    {
-      NS_LOG_DEBUG("start " << i->GetTime() << " GetDelta ()" << i->GetDelta (m_antennaMode));
-      m_firstPower += i->GetDelta (m_antennaMode);
-    }
-  m_niChanges.erase (m_niChanges.begin (), nowIterator);
-
-  NS_LOG_DEBUG ("firstPower=" << m_firstPower);
-  for (NiChanges::iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
-    {
-      NS_LOG_DEBUG ("deleta=" << i->GetDelta (m_antennaMode));
-    }
+  // whatever happened before the event started only matters through
+  // its sum: fold it so that the timeline begins with the event.
+  FoldNiChanges (event->m_startChange);
+  NS_LOG_DEBUG ("firstPower=" << m_firstPower[m_antennaState->mode]);
 
   NiChanges ni;
   double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
-  NS_LOG_DEBUG ("firstPower=" << m_firstPower);
-  for (NiChanges::iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
-    {
-      NS_LOG_DEBUG ("[deleta]=" << i->GetDelta (m_antennaMode));
-    }
-  double snr = CalculateSnr (event->GetRxPowerW (m_antennaMode),
+  double snr = CalculateSnr (event->GetRxPowerW (m_antennaState->mode),
                              noiseInterferenceW,
                              event->GetPayloadMode ());
 
@@ -712,25 +580,12 @@ InterferenceHelper::CalculateSnrPer (Ptr<InterferenceHelper::Event> event)
    */
   double per = CalculatePer (event, &ni);
 
-  // sum noise
-  NS_LOG_DEBUG("[firstPower] "<< m_firstPower);
-  endIterator = GetEventEndPosition (event);
-  endIterator += 1;
-  for (NiChanges::iterator i = m_niChanges.begin (); i != endIterator; i++)
-    {
-      NS_LOG_DEBUG("start " << i->GetTime() << " GetDelta ()" << i->GetDelta (m_antennaMode));
-      m_firstPower += i->GetDelta (m_antennaMode);
-    }
-  m_niChanges.erase (m_niChanges.begin (), endIterator);
-  NS_LOG_DEBUG ("#####################################");
-  NS_LOG_DEBUG ("firstPower=" << m_firstPower);
-  for (NiChanges::iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
-    {
-      for(int m = 0 ; m < 5; m++){
-        NS_LOG_DEBUG ("deleta=" << i->GetDelta (m));
-      }
-    }
-  NS_LOG_DEBUG ("#####################################");
+  // the event is over, fold it together with everything up to its end.
+  NiTimeline::iterator afterEnd = event->m_endChange;
+  afterEnd++;
+  FoldNiChanges (afterEnd);
+  NS_LOG_DEBUG ("firstPower=" << m_firstPower[m_antennaState->mode] <<
+                ", pending changes=" << m_niChanges.size ());
 
   struct SnrPer snrPer;
   snrPer.snr = snr;
@@ -743,70 +598,39 @@ InterferenceHelper::EraseEvents (void)
 {
   m_niChanges.clear ();
   m_rxing = false;
-  m_firstPower = 0.0;
-}
-InterferenceHelper::NiChanges::iterator
-InterferenceHelper::GetPosition (Time moment)
-{
-  double zero [WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-  for(int i = 0; i <WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
-    zero[i] = 0;
-  }
-  return std::upper_bound (m_niChanges.begin (), m_niChanges.end (), NiChange (moment, zero));
+  m_firstPower = PerModePower ();
+  m_energyTracker.Clear ();
 }
 
-InterferenceHelper::NiChanges::iterator
-InterferenceHelper::GetEventPosition (Ptr<InterferenceHelper::Event> event)
+InterferenceHelper::NiTimeline::iterator
+InterferenceHelper::AddNiChangeEvent (Time time, const PerModePower &delta)
 {
-  NiChanges::iterator i;
-  for (i = m_niChanges.begin (); i != m_niChanges.end (); i++){
-    if (event->GetStartTime () != i->GetTime ()){
-      continue;
-    }
-    int j;
-    for(j = 0; j < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; j++){
-      if(i->GetDelta (j) >= Seconds(0) &&
-         event->GetRxPowerW (j) != i->GetDelta (j))
-        {
-          break;
-        }
-    }
-    if(j == WifiAntennaModel::NUMBER_OF_ANTENNA_MODES){
-      NS_LOG_DEBUG("[mark]" << i->GetDelta (m_antennaMode));
-      return i;
-    }
-  }
-  return i;
+  m_energyTracker.Add (time, m_nextSeq, delta);
+  return m_niChanges.insert (NiChange (time, delta, m_nextSeq++)).first;
 }
-InterferenceHelper::NiChanges::iterator
-InterferenceHelper::GetEventEndPosition (Ptr<InterferenceHelper::Event> event)
+void
+InterferenceHelper::FoldNiChanges (NiTimeline::iterator end)
 {
-  NiChanges::iterator i;
-  for (i = m_niChanges.begin (); i != m_niChanges.end (); i++){
-    if (event->GetEndTime () != i->GetTime ()){
-      continue;
-    }
-    int j;
-    for(j = 0; j < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; j++){
-      if(i->GetDelta (j) <= Seconds(0) &&
-         -event->GetRxPowerW (j) != i->GetDelta (j))
-        {
-          break;
-        }
-    }
-    if (j == WifiAntennaModel::NUMBER_OF_ANTENNA_MODES){
-      NS_LOG_DEBUG("[mark2]" <<i->GetTime () << i->GetDelta (m_antennaMode));
-      return i;
+  NiTimeline::iterator i = m_niChanges.begin ();
+  while (i != end)
+    {
+      NS_ASSERT (i != m_niChanges.end ());
+      m_firstPower += i->GetDelta ();
+      m_niChanges.erase (i++);
     }
-
-  }
-  return i;
 }
-
 void
-InterferenceHelper::AddNiChangeEvent (NiChange change)
+InterferenceHelper::PruneNiChanges (void)
 {
-  m_niChanges.insert (GetPosition (change.GetTime ()), change);
+  Time now = Simulator::Now ();
+  m_energyTracker.Advance (now);
+  if (m_rxing)
+    {
+      // the changes since the start of the packet are still needed
+      // to compute its error rate.
+      return;
+    }
+  FoldNiChanges (m_niChanges.lower_bound (NiChange (now - m_horizon, PerModePower ())));
 }
 void
 InterferenceHelper::NotifyRxStart ()
@@ -820,21 +644,10 @@ InterferenceHelper::NotifyRxEnd ()
 }
 
 void
-InterferenceHelper::SetupAntennaListener (Ptr<WifiAntennaModel> antenna)
+InterferenceHelper::SetupAntennaState (Ptr<WifiAntennaModel> antenna)
 {
   NS_LOG_FUNCTION (this << antenna);
-  if (m_antennaListener != 0)
-    {
-      delete m_antennaListener;
-    }
-  m_antennaListener = new AntennaListenerInterferenceHelper (this);
-  antenna->RegisterListener (m_antennaListener);
-}
-void
-InterferenceHelper::NotifyChangeAntennaModeNow (int mode)
-{
-  NS_LOG_FUNCTION (this << mode);
-  m_antennaMode = mode;
+  m_antennaState = antenna->GetState ();
 }
 
 } // namespace ns3
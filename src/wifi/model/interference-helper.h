@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <vector>
 #include <list>
+#include <set>
 #include "wifi-mode.h"
 #include "wifi-preamble.h"
 #include "wifi-phy-standard.h"
@@ -30,11 +31,12 @@
 #include "ns3/simple-ref-count.h"
 #include "ns3/wifi-tx-vector.h"
 #include "ns3/wifi-antenna-model.h"
+#include "per-mode-power.h"
+#include "interference-energy-tracker.h"
 
 namespace ns3 {
 
 class ErrorRateModel;
-class AntennaListenerInterferenceHelper;
 
 /**
  * \ingroup wifi
@@ -42,6 +44,63 @@ class AntennaListenerInterferenceHelper;
  */
 class InterferenceHelper
 {
+private:
+  /**
+   * Noise and Interference (thus Ni) event.
+   */
+  class NiChange
+  {
+public:
+    /**
+     * Create a NiChange at the given time and the amount of NI change.
+     *
+     * \param time time of the event
+     * \param delta the power of each antenna mode
+     * \param seq the insertion order among changes of the same time
+     */
+    NiChange (Time time, const PerModePower &delta, uint64_t seq = 0);
+    /**
+     * Return the event time.
+     *
+     * \return the event time.
+     */
+    Time GetTime (void) const;
+    /**
+     * Return the power
+     *
+     * \return the power
+     */
+    double GetDelta (int mode) const;
+    /**
+     * Return the power of every antenna mode
+     *
+     * \return the power of every antenna mode
+     */
+    const PerModePower & GetDelta (void) const;
+    /**
+     * Compare the event time, then the insertion order, of two
+     * NiChange objects (a < o).
+     *
+     * \param o
+     * \return true if a is ordered before o, false otherwise
+     */
+    bool operator < (const NiChange& o) const;
+private:
+    Time m_time;
+    PerModePower m_delta;
+    uint64_t m_seq;
+  };
+  /**
+   * typedef for a vector of NiChanges
+   */
+  typedef std::vector <NiChange> NiChanges;
+  /**
+   * typedef for the timeline of pending NiChanges, ordered by time
+   * then by insertion order. Iterators stay valid until the change
+   * is folded into the first power.
+   */
+  typedef std::set <NiChange> NiTimeline;
+
 public:
   /**
    * Signal event for a packet.
@@ -56,12 +115,12 @@ public:
      * \param payloadMode Wi-Fi mode used for the payload
      * \param preamble preamble type
      * \param duration duration of the signal
-     * \param rxPower the receive power (w)
+     * \param rxPower the receive power (w) of each antenna mode
      * \param txvector TXVECTOR of the packet
      */
     Event (uint32_t size, WifiMode payloadMode,
            enum WifiPreamble preamble,
-           Time duration, double rxPower[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES],
+           Time duration, const PerModePower &rxPower,
            WifiTxVector txvector);
     ~Event ();
 
@@ -89,7 +148,12 @@ public:
      * \return the receive power (w)
      */
     double GetRxPowerW (int mode) const;
-    double* GetAllRxPowerW (void);
+    /**
+     * Return the receive power (w) of every antenna mode.
+     *
+     * \return the receive power (w) of every antenna mode
+     */
+    const PerModePower & GetAllRxPowerW (void) const;
     /**
      * Return the size of the packet (bytes).
      *
@@ -116,13 +180,17 @@ public:
     WifiTxVector GetTxVector (void) const;
 
 private:
+    friend class InterferenceHelper;
+
     uint32_t m_size;
     WifiMode m_payloadMode;
     enum WifiPreamble m_preamble;
     Time m_startTime;
     Time m_endTime;
-    double m_rxPowerW [WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
+    PerModePower m_rxPowerW;
     WifiTxVector m_txVector;
+    NiTimeline::iterator m_startChange; //!< change adding the signal
+    NiTimeline::iterator m_endChange; //!< change removing the signal
   };
   /**
    * A struct for both SNR and PER
@@ -155,6 +223,26 @@ private:
    * \return the noise figure
    */
   double GetNoiseFigure (void) const;
+  /**
+   * Set how long change points are kept before they are folded into
+   * the first power. Pruning happens when a signal is added and no
+   * packet is being received.
+   *
+   * \param horizon the history horizon
+   */
+  void SetHorizon (Time horizon);
+  /**
+   * Return the history horizon.
+   *
+   * \return the history horizon
+   */
+  Time GetHorizon (void) const;
+  /**
+   * Return the number of change points which are not yet folded.
+   *
+   * \return the number of pending change points
+   */
+  uint32_t GetNPendingChanges (void) const;
   /**
    * Return the error rate model.
    *
@@ -169,6 +257,29 @@ private:
    *          the requested threshold.
    */
   Time GetEnergyDuration (double energyW);
+  /**
+   * Same as GetEnergyDuration (energyW), but for the given antenna
+   * mode rather than the current one.
+   *
+   * \param energyW the minimum energy (W) requested
+   * \param mode the antenna mode
+   * \returns the expected amount of time the observed
+   *          energy on the medium will be higher than
+   *          the requested threshold.
+   */
+  Time GetEnergyDuration (double energyW, int mode);
+  /**
+   * Same as GetEnergyDuration (energyW, mode) for every antenna mode
+   * at once.
+   *
+   * \param energyW the minimum energy (W) requested
+   * \param nModes the number of antenna modes to answer for
+   * \param durations set to the expected amount of time the observed
+   *        energy of each of the nModes first antenna modes will be
+   *        higher than the requested threshold.
+   */
+  void GetEnergyDurations (double energyW, uint32_t nModes,
+                           Time durations[WifiAntennaModel::MAX_ANTENNA_MODES]);
 
   /**
    * Add the packet-related signal to interference helper.
@@ -177,13 +288,13 @@ private:
    * \param payloadMode Wi-Fi mode for the payload
    * \param preamble Wi-Fi preamble for the packet
    * \param duration the duration of the signal
-   * \param rxPower receive power (w)
+   * \param rxPower receive power (w) of each antenna mode
    * \param txvector TXVECTOR of the packet
    * \return InterferenceHelper::Event
    */
   Ptr<InterferenceHelper::Event> Add (uint32_t size, WifiMode payloadMode,
                                       enum WifiPreamble preamble,
-                                      Time duration, double rxPower[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES],
+                                      Time duration, const PerModePower &rxPower,
                                       WifiTxVector txvector);
 
   /**
@@ -207,52 +318,16 @@ private:
    */
   void EraseEvents (void);
     
-  void SetupAntennaListener (Ptr<WifiAntennaModel> antenna);
-  void NotifyChangeAntennaModeNow (int mode);
-
-private:
-
   /**
-   * Noise and Interference (thus Ni) event.
+   * Share the mode of the antenna, which selects the power of the
+   * events used for SNR and energy detection.
+   *
+   * \param antenna the antenna of the PHY
    */
-  class NiChange
-  {
-public:
-    /**
-     * Create a NiChange at the given time and the amount of NI change.
-     *
-     * \param time time of the event
-     * \param delta the power
-     */
-    NiChange (Time time, double* delta);
-    /**
-     * Return the event time.
-     *
-     * \return the event time.
-     */
-    Time GetTime (void) const;
-    /**
-     * Return the power
-     *
-     * \return the power
-     */
-    double GetDelta (int mode) const;
-    double* GetDelta ();
-    /**
-     * Compare the event time of two NiChange objects (a < o).
-     *
-     * \param o
-     * \return true if a < o.time, false otherwise
-     */
-    bool operator < (const NiChange& o) const;
+  void SetupAntennaState (Ptr<WifiAntennaModel> antenna);
+
 private:
-    Time m_time;
-    double m_delta [WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-  };
-  /**
-   * typedef for a vector of NiChanges
-   */
-  typedef std::vector <NiChange> NiChanges;
+
   /**
    * typedef for a list of Events
    */
@@ -307,22 +382,34 @@ private:
   double m_noiseFigure; /**< noise figure (linear) */
   Ptr<ErrorRateModel> m_errorRateModel;
   /// Experimental: needed for energy duration calculation
-  NiChanges m_niChanges;
-  double m_firstPower;
+  NiTimeline m_niChanges;
+  PerModePower m_firstPower; //!< sum of the changes already folded, per antenna mode
+  uint64_t m_nextSeq; //!< insertion order of the next NiChange
+  InterferenceEnergyTracker m_energyTracker; //!< answers the energy duration queries
+  Time m_horizon; //!< how long change points are kept
   bool m_rxing;
-  int m_antennaMode;
-  AntennaListenerInterferenceHelper* m_antennaListener;
+  Ptr<WifiAntennaState> m_antennaState; //!< Shared with the antenna and the MAC
 
-  /// Returns an iterator to the first nichange, which is later than moment
-  NiChanges::iterator GetPosition (Time moment);
-  NiChanges::iterator GetEventPosition (Ptr<InterferenceHelper::Event> event);
-  NiChanges::iterator GetEventEndPosition (Ptr<InterferenceHelper::Event> event);
   /**
-   * Add NiChange to the list at the appropriate position.
+   * Add NiChange to the timeline at the appropriate position.
+   *
+   * \param time the time of the change
+   * \param delta the power change of each antenna mode
+   * \return the position of the change in the timeline
+   */
+  NiTimeline::iterator AddNiChangeEvent (Time time, const PerModePower &delta);
+  /**
+   * Add every change before the given position to the first power
+   * and remove it from the timeline.
    *
-   * \param change
+   * \param end the first change to keep
+   */
+  void FoldNiChanges (NiTimeline::iterator end);
+  /**
+   * Fold the change points which are older than the horizon, unless
+   * a packet is being received.
    */
-  void AddNiChangeEvent (NiChange change);
+  void PruneNiChanges (void);
 };
 
 } // namespace ns3
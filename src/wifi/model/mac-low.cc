@@ -47,29 +47,6 @@ NS_LOG_COMPONENT_DEFINE ("MacLow");
 
 
 namespace ns3 {
-class AntennaListenerMacLow : public ns3::WifiAntennaListener
-{
-public:
-  /**
-   * Create a AntennaListenerMacLow for the given MacLow.
-   *
-   * \param state
-   */
-  AntennaListenerMacLow (ns3::MacLow *low)
-    : m_low (low)
-  {
-  }
-  virtual ~AntennaListenerMacLow ()
-  {
-  }
-  virtual void NotifyChangeAntennaMode (int mode)
-  {
-    m_low->NotifyChangeAntennaModeNow (mode);
-  }
-private:
-  ns3::MacLow *m_low;  //!< MacLow to forward events to
-};
-
 MacLowTransmissionListener::MacLowTransmissionListener ()
 {
 }
@@ -326,13 +303,14 @@ MacLow::MacLow ()
     m_endTxNoAckEvent (),
     m_currentPacket (0),
     m_listener (0),
-    m_antennaMode (0),
-    m_antennaListener (0),
+    m_antennaState (Create<WifiAntennaState> ()),
+    m_lastGeoTagPosition (Vector (0, 0, 0)),
+    m_lastGeoTagTime (Seconds (0)),
     m_phyMacLowListener (0),
     m_ctsToSelfSupported (false)
 {
   NS_LOG_FUNCTION (this);
-  for(int i = 0; i < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
+  for(int i = 0; i < WifiAntennaModel::MAX_ANTENNA_MODES; i++){
     m_lastNavDuration[i] = Seconds (0);
     m_lastNavStart[i] = Seconds (0);
   }
@@ -375,12 +353,6 @@ MacLow::DoDispose (void)
 	  delete m_phyMacLowListener;
 	  m_phyMacLowListener = 0;
     }
-
-  if (m_antennaListener != 0)
-    {
-      delete m_antennaListener;
-      m_antennaListener = 0;
-    }
 }
 
 void
@@ -462,7 +434,7 @@ MacLow::SetPhy (Ptr<WifiPhy> phy)
   m_phy->SetReceiveOkCallback (MakeCallback (&MacLow::ReceiveOk, this));
   m_phy->SetReceiveErrorCallback (MakeCallback (&MacLow::ReceiveError, this));
   SetupPhyMacLowListener (phy);
-  SetupAntennaListener (phy->GetAntenna ());
+  SetupAntennaState (phy->GetAntenna ());
 }
 void
 MacLow::SetWifiRemoteStationManager (Ptr<WifiRemoteStationManager> manager)
@@ -687,8 +659,8 @@ MacLow::NotifySwitchingStartNow (Time duration)
     {
       m_navCounterResetCtsMissed.Cancel ();
     }
-  m_lastNavStart[m_antennaMode] = Simulator::Now ();
-  m_lastNavDuration[m_antennaMode] = Seconds (0);
+  m_lastNavStart[m_antennaState->mode] = Simulator::Now ();
+  m_lastNavDuration[m_antennaState->mode] = Seconds (0);
   m_currentPacket = 0;
   m_listener = 0;
 }
@@ -707,31 +679,42 @@ MacLow::ReceiveOk (Ptr<Packet> packet, double rxSnr, WifiMode txMode, WifiPreamb
 
   // AOA (Angle of arrival)
   GeographyTag geoTag;
-  bool flgGeoTag = packet->RemovePacketTag (geoTag);
-  if (flgGeoTag && hdr.GetAddr1 () == m_self){
+  bool flgGeoTag = false;
+  bool learnsFromTags = m_phy->GetGeographyTable ()->IsLearnedFromTags ();
+  if (learnsFromTags || hdr.IsCts () || hdr.IsAck ())
+    {
+      m_phy->GetGeographyTable ()->ConfigureTag (geoTag);
+      flgGeoTag = packet->RemovePacketTag (geoTag);
+    }
+  if (flgGeoTag && learnsFromTags && hdr.GetAddr1 () == m_self){
     if (hdr.IsRts ()){
-      m_phy->GetGeographyTable ()->UpdateTable (hdr.GetAddr2 (), geoTag.Get ());
+      UpdateGeography (hdr.GetAddr2 (), geoTag);
     }else if (hdr.IsCts ()){
       if (!m_currentHdr.GetAddr1 ().IsBroadcast ()){
-        m_phy->GetGeographyTable ()->UpdateTable (m_currentHdr.GetAddr1 (), geoTag.Get ());
+        UpdateGeography (m_currentHdr.GetAddr1 (), geoTag);
       }
     }else if (hdr.IsAck ()){
       if (!m_currentHdr.GetAddr1 ().IsBroadcast ()){
-        m_phy->GetGeographyTable ()->UpdateTable (m_currentHdr.GetAddr1 (), geoTag.Get ());
+        UpdateGeography (m_currentHdr.GetAddr1 (), geoTag);
       }
     }else{
       if (!hdr.GetAddr2 ().IsBroadcast ()){
-        m_phy->GetGeographyTable ()->UpdateTable (hdr.GetAddr2 (), geoTag.Get ());
+        UpdateGeography (hdr.GetAddr2 (), geoTag);
       }
     }
   }
 
   int nextAntennaMode = WifiSwitchedBeamAntennaModel::OMNI;
   if (flgGeoTag){
-    Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
+    MobilityModel *mobility = m_phy->PeekMobilityModel ();
     Vector v = mobility->GetPosition ();
-    Angles bet = Angles (geoTag.Get (), v);
-    nextAntennaMode = GetNextAntennaMode (bet);
+    Vector sender = geoTag.Get ();
+    nextAntennaMode = GetNextAntennaMode (Vector (sender.x - v.x, sender.y - v.y, sender.z - v.z));
+  }else if (!hdr.IsCts () && !hdr.IsAck ()){
+    // frames of a sender which has not moved, or of any sender when
+    // the table is an oracle, carry no position: ask the table. CTS
+    // and ACK frames always carry it, see ForwardDown.
+    nextAntennaMode = GetNextAntennaMode (hdr.GetAddr2 ());
   }
 
   bool isPrevNavZero = IsNavZero (nextAntennaMode);
@@ -1032,7 +1015,7 @@ MacLow::GetAckDuration (WifiTxVector ackTxVector) const
     preamble= WIFI_PREAMBLE_HT_MF;
   else
     preamble=WIFI_PREAMBLE_LONG;
-  return m_phy->CalculateTxDuration (GetAckSize (), ackTxVector, preamble);
+  return m_phy->GetTxDuration (GetAckSize (), ackTxVector, preamble);
 }
 Time
 MacLow::GetBlockAckDuration (Mac48Address to, WifiTxVector blockAckReqTxVector, enum BlockAckType type) const
@@ -1050,7 +1033,7 @@ MacLow::GetBlockAckDuration (Mac48Address to, WifiTxVector blockAckReqTxVector,
     preamble= WIFI_PREAMBLE_HT_MF;
   else
     preamble=WIFI_PREAMBLE_LONG;
-  return m_phy->CalculateTxDuration (GetBlockAckSize (type), blockAckReqTxVector, preamble);
+  return m_phy->GetTxDuration (GetBlockAckSize (type), blockAckReqTxVector, preamble);
 }
 Time
 MacLow::GetCtsDuration (Mac48Address to, WifiTxVector rtsTxVector) const
@@ -1067,7 +1050,7 @@ MacLow::GetCtsDuration (WifiTxVector ctsTxVector) const
     preamble= WIFI_PREAMBLE_HT_MF;
   else
     preamble=WIFI_PREAMBLE_LONG;
-  return m_phy->CalculateTxDuration (GetCtsSize (), ctsTxVector, preamble);
+  return m_phy->GetTxDuration (GetCtsSize (), ctsTxVector, preamble);
 }
 uint32_t
 MacLow::GetCtsSize (void) const
@@ -1155,7 +1138,7 @@ MacLow::CalculateOverallTxTime (Ptr<const Packet> packet,
         {
           preamble = WIFI_PREAMBLE_LONG;
         }
-      txTime += m_phy->CalculateTxDuration (GetRtsSize (), rtsTxVector, preamble);
+      txTime += m_phy->GetTxDuration (GetRtsSize (), rtsTxVector, preamble);
       txTime += GetCtsDuration (hdr->GetAddr1 (), rtsTxVector);
       txTime += Time (GetSifs () * 2);
     }
@@ -1168,7 +1151,7 @@ MacLow::CalculateOverallTxTime (Ptr<const Packet> packet,
   else
     preamble=WIFI_PREAMBLE_LONG;
   uint32_t dataSize = GetSize (packet, hdr);
-  txTime += m_phy->CalculateTxDuration (dataSize, dataTxVector, preamble);
+  txTime += m_phy->GetTxDuration (dataSize, dataTxVector, preamble);
   if (params.MustWaitAck ())
     {
       txTime += GetSifs ();
@@ -1195,7 +1178,7 @@ MacLow::CalculateTransmissionTime (Ptr<const Packet> packet,
       else
         preamble=WIFI_PREAMBLE_LONG;
       txTime += GetSifs ();
-      txTime += m_phy->CalculateTxDuration (params.GetNextPacketSize (), dataTxVector, preamble);
+      txTime += m_phy->GetTxDuration (params.GetNextPacketSize (), dataTxVector, preamble);
     }
   return txTime;
 }
@@ -1235,7 +1218,7 @@ MacLow::NotifyNav (Ptr<const Packet> packet,const WifiMacHeader &hdr, WifiMode t
           cts.SetType (WIFI_MAC_CTL_CTS);
           WifiTxVector txVector=GetRtsTxVector (packet, &hdr);
           Time navCounterResetCtsMissedDelay =
-            m_phy->CalculateTxDuration (cts.GetSerializedSize (), txVector, preamble) +
+            m_phy->GetTxDuration (cts.GetSerializedSize (), txVector, preamble) +
             Time (2 * GetSifs ()) + Time (2 * GetSlotTime ());
           m_navCounterResetCtsMissed = Simulator::Schedule (navCounterResetCtsMissedDelay,
                                                             &MacLow::NavCounterResetCtsMissed, this,
@@ -1260,8 +1243,8 @@ MacLow::DoNavResetNow (Time duration)
     {
       (*i)->NavReset (duration);
     }
-  m_lastNavStart[m_antennaMode] = Simulator::Now ();
-  m_lastNavStart[m_antennaMode] = duration;
+  m_lastNavStart[m_antennaState->mode] = Simulator::Now ();
+  m_lastNavStart[m_antennaState->mode] = duration;
 }
 bool
 MacLow::DoNavStartNow (Time duration, int mode)
@@ -1338,11 +1321,32 @@ MacLow::ForwardDown (Ptr<const Packet> packet, const WifiMacHeader* hdr,
                 ", duration=" << hdr->GetDuration () <<
                 ", seq=0x" << std::hex << m_currentHdr.GetSequenceControl () << std::dec);
 
-  Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
-  Vector v = mobility->GetPosition ();
-  GeographyTag geoTag;
-  geoTag.Set (v);
-  packet->AddPacketTag (geoTag);
+  Ptr<GeographyTable> table = m_phy->GetGeographyTable ();
+  // CTS and ACK frames have no transmitter address to look the sender
+  // up by, even in an oracle: they always carry its position, so that
+  // the nodes overhearing them set their NAV in its direction. The
+  // movement policy applies to the frames that carry an address only.
+  bool hasTransmitter = !hdr->IsCts () && !hdr->IsAck ();
+  if (!hasTransmitter || table->IsLearnedFromTags ())
+    {
+      MobilityModel *mobility = m_phy->PeekMobilityModel ();
+      Vector v = mobility->GetPosition ();
+      if (!hasTransmitter || NeedsGeographyTag (v))
+        {
+          GeographyTag geoTag;
+          table->ConfigureTag (geoTag);
+          geoTag.Set (v);
+          if (table->GetAdvertiseVelocity ())
+            {
+              Vector velocity = mobility->GetVelocity ();
+              if (velocity.x != 0 || velocity.y != 0 || velocity.z != 0)
+                {
+                  geoTag.SetVelocity (velocity);
+                }
+            }
+          packet->AddPacketTag (geoTag);
+        }
+    }
 
   m_phy->SendPacket (packet, txVector.GetMode(), preamble, txVector);
 }
@@ -1443,11 +1447,11 @@ MacLow::SendRtsForPacket (void)
     SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
   }else{
     bool existsAddress = false;
-    Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
+    MobilityModel *mobility = m_phy->PeekMobilityModel ();
     Vector v = mobility->GetPosition ();
-    Angles bet = m_phy->GetGeographyTable ()->GetAngle (rts.GetAddr1(), v, &existsAddress);
+    Vector direction = m_phy->GetGeographyTable ()->GetDisplacement (rts.GetAddr1(), v, &existsAddress);
     if(existsAddress){
-      SetAntennaMode (bet);
+      SetAntennaMode (direction);
     }else{
       SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
     }
@@ -1472,14 +1476,14 @@ MacLow::SendRtsForPacket (void)
       duration += GetSifs ();
       duration += GetCtsDuration (m_currentHdr.GetAddr1 (), rtsTxVector);
       duration += GetSifs ();
-      duration += m_phy->CalculateTxDuration (GetSize (m_currentPacket, &m_currentHdr),
+      duration += m_phy->GetTxDuration (GetSize (m_currentPacket, &m_currentHdr),
                                               dataTxVector, preamble);
       duration += GetSifs ();
       duration += GetAckDuration (m_currentHdr.GetAddr1 (), dataTxVector);
     }
   rts.SetDuration (duration);
 
-  Time txDuration = m_phy->CalculateTxDuration (GetRtsSize (), rtsTxVector, preamble);
+  Time txDuration = m_phy->GetTxDuration (GetRtsSize (), rtsTxVector, preamble);
   Time timerDelay = txDuration + GetCtsTimeout ();
 
   NS_ASSERT (m_ctsTimeoutEvent.IsExpired ());
@@ -1507,7 +1511,7 @@ MacLow::StartDataTxTimers (WifiTxVector dataTxVector)
   else
     preamble=WIFI_PREAMBLE_LONG;
  
-  Time txDuration = m_phy->CalculateTxDuration (GetSize (m_currentPacket, &m_currentHdr), dataTxVector, preamble);
+  Time txDuration = m_phy->GetTxDuration (GetSize (m_currentPacket, &m_currentHdr), dataTxVector, preamble);
   if (m_txParams.MustWaitNormalAck ())
     {
       Time timerDelay = txDuration + GetAckTimeout ();
@@ -1607,7 +1611,7 @@ MacLow::SendDataPacket (void)
       if (m_txParams.HasNextPacket ())
         {
           duration += GetSifs ();
-          duration += m_phy->CalculateTxDuration (m_txParams.GetNextPacketSize (),
+          duration += m_phy->GetTxDuration (m_txParams.GetNextPacketSize (),
                                                   dataTxVector, preamble);
           if (m_txParams.MustWaitAck ())
             {
@@ -1674,7 +1678,7 @@ MacLow::SendCtsToSelf (void)
     {
       WifiTxVector dataTxVector = GetDataTxVector (m_currentPacket, &m_currentHdr);
       duration += GetSifs ();
-      duration += m_phy->CalculateTxDuration (GetSize (m_currentPacket,&m_currentHdr),
+      duration += m_phy->GetTxDuration (GetSize (m_currentPacket,&m_currentHdr),
                                               dataTxVector, preamble);
       if (m_txParams.MustWaitBasicBlockAck ())
         {
@@ -1695,7 +1699,7 @@ MacLow::SendCtsToSelf (void)
       if (m_txParams.HasNextPacket ())
         {
           duration += GetSifs ();
-          duration += m_phy->CalculateTxDuration (m_txParams.GetNextPacketSize (),
+          duration += m_phy->GetTxDuration (m_txParams.GetNextPacketSize (),
                                                   dataTxVector, preamble);
           if (m_txParams.MustWaitCompressedBlockAck ())
             {
@@ -1719,7 +1723,7 @@ MacLow::SendCtsToSelf (void)
 
   ForwardDown (packet, &cts, ctsTxVector,preamble);
 
-  Time txDuration = m_phy->CalculateTxDuration (GetCtsSize (), ctsTxVector, preamble);
+  Time txDuration = m_phy->GetTxDuration (GetCtsSize (), ctsTxVector, preamble);
   txDuration += GetSifs ();
   NS_ASSERT (m_sendDataEvent.IsExpired ());
   
@@ -1769,11 +1773,11 @@ MacLow::SendCtsAfterRts (Mac48Address source, Time duration, WifiMode rtsTxMode,
     SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
   }else{
     bool existsAddress = false;
-    Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
+    MobilityModel *mobility = m_phy->PeekMobilityModel ();
     Vector v = mobility->GetPosition ();
-    Angles bet = m_phy->GetGeographyTable ()->GetAngle (source, v, &existsAddress);
+    Vector direction = m_phy->GetGeographyTable ()->GetDisplacement (source, v, &existsAddress);
     if(existsAddress){
-      SetAntennaMode (bet);
+      SetAntennaMode (direction);
     }else{
       SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
     }
@@ -1805,7 +1809,7 @@ MacLow::SendDataAfterCts (Mac48Address source, Time duration, WifiMode txMode)
   Time newDuration = Seconds (0);
   newDuration += GetSifs ();
   newDuration += GetAckDuration (m_currentHdr.GetAddr1 (), dataTxVector);
-  Time txDuration = m_phy->CalculateTxDuration (GetSize (m_currentPacket, &m_currentHdr),
+  Time txDuration = m_phy->GetTxDuration (GetSize (m_currentPacket, &m_currentHdr),
                                                 dataTxVector, preamble);
   duration -= txDuration;
   duration -= GetSifs ();
@@ -2220,21 +2224,41 @@ MacLow::RegisterBlockAckListenerForAc (enum AcIndex ac, MacLowBlockAckEventListe
   m_edcaListeners.insert (std::make_pair (ac, listener));
 }
 void
-MacLow::SetupAntennaListener (Ptr<WifiAntennaModel> antenna)
+MacLow::SetupAntennaState (Ptr<WifiAntennaModel> antenna)
 {
   NS_LOG_FUNCTION (this << antenna);
-  if (m_antennaListener != 0)
+  m_antennaState = antenna->GetState ();
+}
+
+void
+MacLow::UpdateGeography (Mac48Address address, const GeographyTag &tag)
+{
+  if (tag.HasVelocity ())
+    {
+      m_phy->GetGeographyTable ()->UpdateTable (address, tag.Get (), tag.GetVelocity ());
+    }
+  else
     {
-      delete m_antennaListener;
+      m_phy->GetGeographyTable ()->UpdateTable (address, tag.Get ());
     }
-  m_antennaListener = new AntennaListenerMacLow (this);
-  antenna->RegisterListener (m_antennaListener);
 }
-void
-MacLow::NotifyChangeAntennaModeNow (int mode)
+
+bool
+MacLow::NeedsGeographyTag (const Vector &position)
 {
-  //  NS_LOG_FUNCTION (this << mode);
-  m_antennaMode = mode;
+  Ptr<GeographyTable> table = m_phy->GetGeographyTable ();
+  double threshold = table->GetTagMovementThreshold ();
+  Time now = Simulator::Now ();
+  if (threshold > 0
+      && m_lastGeoTagTime > Seconds (0)
+      && now - m_lastGeoTagTime < table->GetTagRefreshInterval ()
+      && CalculateDistance (position, m_lastGeoTagPosition) < threshold)
+    {
+      return false;
+    }
+  m_lastGeoTagPosition = position;
+  m_lastGeoTagTime = now;
+  return true;
 }
 
 void
@@ -2249,6 +2273,12 @@ MacLow::SetAntennaMode (Angles bet)
   NS_LOG_FUNCTION (this << bet);
   m_phy->GetAntenna ()->SetAntennaMode (bet);
 }
+void
+MacLow::SetAntennaMode (const Vector &direction)
+{
+  NS_LOG_FUNCTION (this << direction);
+  m_phy->GetAntenna ()->SetAntennaMode (direction);
+}
 
 int
 MacLow::GetNextAntennaMode (Mac48Address addr)
@@ -2257,11 +2287,11 @@ MacLow::GetNextAntennaMode (Mac48Address addr)
 
   // set antenna mode
   bool existsAddress = false;
-  Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
+  MobilityModel *mobility = m_phy->PeekMobilityModel ();
   Vector v = mobility->GetPosition ();
-  Angles bet = m_phy->GetGeographyTable ()->GetAngle (addr, v, &existsAddress);
+  Vector direction = m_phy->GetGeographyTable ()->GetDisplacement (addr, v, &existsAddress);
   if(existsAddress){
-    return m_phy->GetAntenna ()->GetNextAntennaMode (bet);
+    return m_phy->GetAntenna ()->GetNextAntennaMode (direction);
   }else{
     return WifiSwitchedBeamAntennaModel::OMNI;
   }
@@ -2272,5 +2302,11 @@ MacLow::GetNextAntennaMode (Angles bet)
   NS_LOG_FUNCTION (this);
   return m_phy->GetAntenna ()->GetNextAntennaMode (bet);
 }
+int
+MacLow::GetNextAntennaMode (const Vector &direction)
+{
+  NS_LOG_FUNCTION (this << direction);
+  return m_phy->GetAntenna ()->GetNextAntennaMode (direction);
+}
 
 } // namespace ns3
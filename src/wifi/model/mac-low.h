@@ -50,7 +50,7 @@ namespace ns3 {
 class WifiPhy;
 class WifiMac;
 class EdcaTxopN;
-class AntennaListenerMacLow;
+class GeographyTag;
 
 /**
  * \ingroup wifi
@@ -680,12 +680,31 @@ public:
    * associated to this AC.
    */
   void RegisterBlockAckListenerForAc (enum AcIndex ac, MacLowBlockAckEventListener *listener);
-  void NotifyChangeAntennaModeNow (int mode);
   void SetAntennaMode (int mode);
   void SetAntennaMode (Angles bet);
+  /**
+   * \param direction position of the other node minus our position
+   */
+  void SetAntennaMode (const Vector &direction);
   int GetNextAntennaMode (Mac48Address addr);
   int GetNextAntennaMode (Angles bet);
+  int GetNextAntennaMode (const Vector &direction);
 protected:
+  /**
+   * Record the position, and the velocity if any, that a frame from
+   * address carried.
+   *
+   * \param address the address of the sender
+   * \param tag the geography tag of the frame
+   */
+  void UpdateGeography (Mac48Address address, const GeographyTag &tag);
+  /**
+   * \param position the current position of this node
+   * \return true if the next frame sent must carry the position, given
+   * the TagMovementThreshold and TagRefreshInterval of the geography
+   * table
+   */
+  bool NeedsGeographyTag (const Vector &position);
   /**
    * Return a TXVECTOR for the DATA frame given the destination.
    * The function consults WifiRemoteStationManager, which controls the rate
@@ -1076,7 +1095,12 @@ private:
    * \param phy the WifiPhy this MacLow is connected to
    */
   void SetupPhyMacLowListener (Ptr<WifiPhy> phy);
-  void SetupAntennaListener (Ptr<WifiAntennaModel> antenna);
+  /**
+   * Share the mode of the antenna, which selects the per-mode NAV.
+   *
+   * \param antenna the antenna of the WifiPhy
+   */
+  void SetupAntennaState (Ptr<WifiAntennaModel> antenna);
 
   Ptr<WifiPhy> m_phy; //!< Pointer to WifiPhy (actually send/receives frames)
   Ptr<WifiRemoteStationManager> m_stationManager; //!< Pointer to WifiRemoteStationManager (rate control)
@@ -1121,10 +1145,11 @@ private:
   Time m_pifs;                              //!< PCF Interframe Space (PIFS) duration
   Time m_rifs;                              //!< Reduced Interframe Space (RIFS) duration
 
-  Time m_lastNavStart[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];     //!< The time when the latest NAV started
-  Time m_lastNavDuration[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];  //!< The duration of the latest NAV
-  int m_antennaMode;
-  AntennaListenerMacLow* m_antennaListener;
+  Time m_lastNavStart[WifiAntennaModel::MAX_ANTENNA_MODES];     //!< The time when the latest NAV started
+  Time m_lastNavDuration[WifiAntennaModel::MAX_ANTENNA_MODES];  //!< The duration of the latest NAV
+  Ptr<WifiAntennaState> m_antennaState; //!< Shared with the antenna and the PHY
+  Vector m_lastGeoTagPosition;  //!< The position carried by the latest geography tag sent
+  Time m_lastGeoTagTime;        //!< The time the latest geography tag was sent
 
   bool m_promisc;  //!< Flag if the device is operating in promiscuous mode
 
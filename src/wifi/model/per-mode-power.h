@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PER_MODE_POWER_H
+#define PER_MODE_POWER_H
+
+#include <stdint.h>
+#include "ns3/assert.h"
+#include "ns3/wifi-antenna-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ * \brief one power value for each antenna mode
+ *
+ * A fixed-capacity value type: it is copied, not shared, so it can be
+ * bound into a scheduled event or stored in an interference event
+ * without any heap allocation. It holds the values of the first
+ * GetNModes () modes; the value of every mode past those is zero, so
+ * values of different sizes can be added. Whether the values are in
+ * dBm or W is up to the user.
+ *
+ * The element-wise loops are unrolled for the common sizes 1 (omni
+ * only), 5, 9 and 17 (omni plus 4, 8 or 16 sectors).
+ */
+class PerModePower
+{
+public:
+  /**
+   * Create an empty vector, i.e., zero for every mode.
+   */
+  PerModePower ()
+    : m_nModes (0)
+  {
+  }
+  /**
+   * Create a vector with the first nModes modes set to the given value.
+   *
+   * \param nModes the number of modes, at most MAX_ANTENNA_MODES
+   * \param value the value of every mode
+   */
+  PerModePower (uint32_t nModes, double value)
+    : m_nModes (nModes)
+  {
+    NS_ASSERT (nModes <= static_cast<uint32_t> (WifiAntennaModel::MAX_ANTENNA_MODES));
+    for (uint32_t i = 0; i < nModes; i++)
+      {
+        m_value[i] = value;
+      }
+  }
+
+  // copy only the stored modes: an omni-only value costs one double
+  PerModePower (const PerModePower &o)
+    : m_nModes (o.m_nModes)
+  {
+    Copy (o);
+  }
+  PerModePower & operator= (const PerModePower &o)
+  {
+    m_nModes = o.m_nModes;
+    Copy (o);
+    return *this;
+  }
+
+  /**
+   * \return the number of modes whose value is stored
+   */
+  uint32_t GetNModes (void) const
+  {
+    return m_nModes;
+  }
+  /**
+   * Store at least nModes modes, the new ones set to zero.
+   *
+   * \param nModes the number of modes, at most MAX_ANTENNA_MODES
+   */
+  void Extend (uint32_t nModes)
+  {
+    NS_ASSERT (nModes <= static_cast<uint32_t> (WifiAntennaModel::MAX_ANTENNA_MODES));
+    for (; m_nModes < nModes; m_nModes++)
+      {
+        m_value[m_nModes] = 0.0;
+      }
+  }
+
+  double & operator[] (int mode)
+  {
+    NS_ASSERT (mode >= 0);
+    Extend (mode + 1);
+    return m_value[mode];
+  }
+  double operator[] (int mode) const
+  {
+    NS_ASSERT (mode >= 0 && mode < WifiAntennaModel::MAX_ANTENNA_MODES);
+    return mode < static_cast<int> (m_nModes) ? m_value[mode] : 0.0;
+  }
+  /**
+   * \return a copy with every value negated
+   */
+  PerModePower operator- (void) const
+  {
+    PerModePower r;
+    r.m_nModes = m_nModes;
+    switch (m_nModes)
+      {
+      case 1: Negate<1> (r.m_value, m_value); break;
+      case 5: Negate<5> (r.m_value, m_value); break;
+      case 9: Negate<9> (r.m_value, m_value); break;
+      case 17: Negate<17> (r.m_value, m_value); break;
+      default:
+        for (uint32_t i = 0; i < m_nModes; i++)
+          {
+            r.m_value[i] = -m_value[i];
+          }
+      }
+    return r;
+  }
+  PerModePower & operator+= (const PerModePower &o)
+  {
+    Extend (o.m_nModes);
+    switch (o.m_nModes)
+      {
+      case 1: Add<1> (m_value, o.m_value); break;
+      case 5: Add<5> (m_value, o.m_value); break;
+      case 9: Add<9> (m_value, o.m_value); break;
+      case 17: Add<17> (m_value, o.m_value); break;
+      default:
+        for (uint32_t i = 0; i < o.m_nModes; i++)
+          {
+            m_value[i] += o.m_value[i];
+          }
+      }
+    return *this;
+  }
+
+private:
+  void Copy (const PerModePower &o)
+  {
+    for (uint32_t i = 0; i < m_nModes; i++)
+      {
+        m_value[i] = o.m_value[i];
+      }
+  }
+  template <int N>
+  static void Negate (double *r, const double *a)
+  {
+    for (int i = 0; i < N; i++)
+      {
+        r[i] = -a[i];
+      }
+  }
+  template <int N>
+  static void Add (double *r, const double *a)
+  {
+    for (int i = 0; i < N; i++)
+      {
+        r[i] += a[i];
+      }
+  }
+
+  uint32_t m_nModes;
+  double m_value[WifiAntennaModel::MAX_ANTENNA_MODES];
+};
+
+} // namespace ns3
+
+#endif /* PER_MODE_POWER_H */
@@ -204,7 +204,7 @@ RegularWifiMac::SetWifiPhy (Ptr<WifiPhy> phy)
   NS_LOG_FUNCTION (this << phy);
   m_phy = phy;
   m_dcfManager->SetupPhyListener (phy);
-  m_dcfManager->SetupAntennaListener (phy->GetAntenna ());
+  m_dcfManager->SetupAntennaState (phy->GetAntenna ());
   m_low->SetPhy (phy);
 }
 
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "wifi-lazy-timer.h"
+#include "ns3/simulator.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("WifiLazyTimer");
+
+namespace ns3 {
+
+WifiLazyTimer::WifiLazyTimer ()
+  : m_armed (false),
+    m_scheduled (0),
+    m_cancelled (0),
+    m_fired (0),
+    m_stale (0)
+{
+}
+
+WifiLazyTimer::~WifiLazyTimer ()
+{
+  m_event.Cancel ();
+}
+
+void
+WifiLazyTimer::SetFunction (Callback<void> callback)
+{
+  m_callback = callback;
+}
+
+void
+WifiLazyTimer::ScheduleAt (Time deadline)
+{
+  NS_LOG_FUNCTION (this << deadline);
+  Time now = Simulator::Now ();
+  NS_ASSERT (deadline >= now);
+  m_deadline = deadline;
+  m_armed = true;
+  if (m_event.IsRunning ())
+    {
+      if (m_eventTime <= deadline)
+        {
+          // the pending event re-arms itself when it runs early.
+          return;
+        }
+      m_event.Cancel ();
+      m_cancelled++;
+    }
+  m_eventTime = deadline;
+  m_event = Simulator::Schedule (deadline - now, &WifiLazyTimer::Expire, this);
+  m_scheduled++;
+}
+
+void
+WifiLazyTimer::Cancel (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_armed = false;
+}
+
+bool
+WifiLazyTimer::IsRunning (void) const
+{
+  return m_armed;
+}
+
+Time
+WifiLazyTimer::GetDeadline (void) const
+{
+  return m_deadline;
+}
+
+uint64_t
+WifiLazyTimer::GetScheduledEvents (void) const
+{
+  return m_scheduled;
+}
+
+uint64_t
+WifiLazyTimer::GetCancelledEvents (void) const
+{
+  return m_cancelled;
+}
+
+uint64_t
+WifiLazyTimer::GetFiredEvents (void) const
+{
+  return m_fired;
+}
+
+uint64_t
+WifiLazyTimer::GetStaleEvents (void) const
+{
+  return m_stale;
+}
+
+void
+WifiLazyTimer::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_armed)
+    {
+      m_stale++;
+      return;
+    }
+  Time now = Simulator::Now ();
+  if (m_deadline > now)
+    {
+      m_stale++;
+      m_eventTime = m_deadline;
+      m_event = Simulator::Schedule (m_deadline - now, &WifiLazyTimer::Expire, this);
+      m_scheduled++;
+      return;
+    }
+  m_armed = false;
+  m_fired++;
+  m_callback ();
+}
+
+} // namespace ns3
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef WIFI_LAZY_TIMER_H
+#define WIFI_LAZY_TIMER_H
+
+#include <stdint.h>
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ * \brief one-shot timer which keeps at most one simulator event
+ *
+ * The timer remembers its deadline separately from the event that
+ * wakes it up. Moving the deadline later, or cancelling the timer,
+ * leaves the pending event in place: when that event runs before
+ * the deadline it simply re-arms itself for the deadline instead of
+ * invoking the callback. Only a deadline which moves before the
+ * pending event costs a cancel and a new schedule.
+ */
+class WifiLazyTimer
+{
+public:
+  WifiLazyTimer ();
+  /**
+   * Cancels the pending event, if any.
+   */
+  ~WifiLazyTimer ();
+
+  /**
+   * \param callback the function invoked when the deadline is reached
+   */
+  void SetFunction (Callback<void> callback);
+  /**
+   * Arm the timer, or move its deadline.
+   *
+   * \param deadline the absolute time at which the callback must run,
+   *        not in the past
+   */
+  void ScheduleAt (Time deadline);
+  /**
+   * Disarm the timer. The pending event, if any, is kept so that a
+   * later ScheduleAt can reuse it.
+   */
+  void Cancel (void);
+  /**
+   * \return true if the callback will be invoked at the deadline
+   */
+  bool IsRunning (void) const;
+  /**
+   * \return the deadline of the armed timer
+   */
+  Time GetDeadline (void) const;
+
+  /**
+   * \return the number of simulator events scheduled by this timer
+   */
+  uint64_t GetScheduledEvents (void) const;
+  /**
+   * \return the number of pending events cancelled because the
+   *         deadline moved before them
+   */
+  uint64_t GetCancelledEvents (void) const;
+  /**
+   * \return the number of events which invoked the callback
+   */
+  uint64_t GetFiredEvents (void) const;
+  /**
+   * \return the number of events which ran early or disarmed and
+   *         did not invoke the callback
+   */
+  uint64_t GetStaleEvents (void) const;
+
+private:
+  void Expire (void);
+
+  Callback<void> m_callback;
+  EventId m_event;
+  Time m_eventTime;  //!< Absolute time of m_event while it is pending
+  Time m_deadline;
+  bool m_armed;
+  uint64_t m_scheduled;
+  uint64_t m_cancelled;
+  uint64_t m_fired;
+  uint64_t m_stale;
+};
+
+} // namespace ns3
+
+#endif /* WIFI_LAZY_TIMER_H */
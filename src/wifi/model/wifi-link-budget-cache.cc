@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "wifi-link-budget-cache.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("WifiLinkBudgetCache");
+
+namespace ns3 {
+
+// a pair of PHY indices never maps to this key since index 0xffffffff
+// would mean four billion PHYs on one channel.
+static const uint64_t EMPTY_KEY = ~static_cast<uint64_t> (0);
+static const uint32_t INITIAL_SLOTS = 64;
+
+WifiLinkBudgetCache::WifiLinkBudgetCache ()
+  : m_size (0)
+{
+}
+
+uint64_t
+WifiLinkBudgetCache::MakeKey (uint32_t tx, uint32_t rx)
+{
+  return (static_cast<uint64_t> (tx) << 32) | rx;
+}
+
+uint32_t
+WifiLinkBudgetCache::FindSlot (uint64_t key) const
+{
+  // Fibonacci hashing followed by linear probing; the table is a
+  // power of two in size and never more than half full.
+  uint32_t mask = m_slots.size () - 1;
+  uint32_t i = static_cast<uint32_t> ((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+  while (m_slots[i].key != key && m_slots[i].key != EMPTY_KEY)
+    {
+      i = (i + 1) & mask;
+    }
+  return i;
+}
+
+bool
+WifiLinkBudgetCache::Lookup (uint32_t tx, uint32_t rx, uint32_t txEpoch, uint32_t rxEpoch,
+                             double &lossDb, Time &delay) const
+{
+  if (m_slots.empty ())
+    {
+      return false;
+    }
+  const Slot &slot = m_slots[FindSlot (MakeKey (tx, rx))];
+  if (slot.key == EMPTY_KEY || slot.txEpoch != txEpoch || slot.rxEpoch != rxEpoch)
+    {
+      return false;
+    }
+  lossDb = slot.lossDb;
+  delay = slot.delay;
+  return true;
+}
+
+void
+WifiLinkBudgetCache::Insert (uint32_t tx, uint32_t rx, uint32_t txEpoch, uint32_t rxEpoch,
+                             double lossDb, Time delay)
+{
+  if (2 * (m_size + 1) > m_slots.size ())
+    {
+      Grow ();
+    }
+  uint64_t key = MakeKey (tx, rx);
+  Slot &slot = m_slots[FindSlot (key)];
+  if (slot.key == EMPTY_KEY)
+    {
+      m_size++;
+    }
+  slot.key = key;
+  slot.txEpoch = txEpoch;
+  slot.rxEpoch = rxEpoch;
+  slot.lossDb = lossDb;
+  slot.delay = delay;
+}
+
+void
+WifiLinkBudgetCache::Grow (void)
+{
+  std::vector<Slot> old;
+  old.swap (m_slots);
+  Slot empty;
+  empty.key = EMPTY_KEY;
+  empty.txEpoch = 0;
+  empty.rxEpoch = 0;
+  empty.lossDb = 0;
+  m_slots.resize (old.empty () ? INITIAL_SLOTS : 2 * old.size (), empty);
+  NS_LOG_DEBUG ("grow to " << m_slots.size () << " slots");
+  for (std::vector<Slot>::const_iterator i = old.begin (); i != old.end (); i++)
+    {
+      if (i->key != EMPTY_KEY)
+        {
+          m_slots[FindSlot (i->key)] = *i;
+        }
+    }
+}
+
+void
+WifiLinkBudgetCache::Clear (void)
+{
+  m_slots.clear ();
+  m_size = 0;
+}
+
+uint32_t
+WifiLinkBudgetCache::GetSize (void) const
+{
+  return m_size;
+}
+
+} // namespace ns3
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef WIFI_LINK_BUDGET_CACHE_H
+#define WIFI_LINK_BUDGET_CACHE_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ * \brief open-addressing table of path loss and propagation delay
+ *
+ * Entries are keyed by the (transmitter, receiver) pair of PHY indices
+ * and tagged with the mobility epoch of both ends at the time they
+ * were computed. An entry whose epochs no longer match is treated as
+ * missing and is overwritten by the next Insert for that pair, so
+ * nothing ever has to be erased.
+ */
+class WifiLinkBudgetCache
+{
+public:
+  WifiLinkBudgetCache ();
+
+  /**
+   * \param tx index of the transmitting PHY
+   * \param rx index of the receiving PHY
+   * \param txEpoch current mobility epoch of the transmitter
+   * \param rxEpoch current mobility epoch of the receiver
+   * \param lossDb set to the cached path loss (dB) on success
+   * \param delay set to the cached propagation delay on success
+   * \return true if a valid entry was found
+   */
+  bool Lookup (uint32_t tx, uint32_t rx, uint32_t txEpoch, uint32_t rxEpoch,
+               double &lossDb, Time &delay) const;
+  /**
+   * Insert or refresh the entry of the pair.
+   *
+   * \param tx index of the transmitting PHY
+   * \param rx index of the receiving PHY
+   * \param txEpoch current mobility epoch of the transmitter
+   * \param rxEpoch current mobility epoch of the receiver
+   * \param lossDb the path loss (dB)
+   * \param delay the propagation delay
+   */
+  void Insert (uint32_t tx, uint32_t rx, uint32_t txEpoch, uint32_t rxEpoch,
+               double lossDb, Time delay);
+  /**
+   * Remove all entries.
+   */
+  void Clear (void);
+  /**
+   * \return the number of pairs stored, stale or not
+   */
+  uint32_t GetSize (void) const;
+
+private:
+  struct Slot
+  {
+    uint64_t key;
+    uint32_t txEpoch;
+    uint32_t rxEpoch;
+    double lossDb;
+    Time delay;
+  };
+
+  static uint64_t MakeKey (uint32_t tx, uint32_t rx);
+  uint32_t FindSlot (uint64_t key) const;
+  void Grow (void);
+
+  std::vector<Slot> m_slots;
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* WIFI_LINK_BUDGET_CACHE_H */
@@ -22,7 +22,6 @@
 #include "ns3/simulator.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/wifi-antenna-model.h"
-#include "ns3/wifi-switched-beam-antenna-model.h"
 
 NS_LOG_COMPONENT_DEFINE ("WifiPhyStateHelper");
 
@@ -30,29 +29,6 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (WifiPhyStateHelper);
 
-class AntennaListenerState : public ns3::WifiAntennaListener
-{
-public:
-  /**
-   * Create a AntennaListenerState for the given WifiPhyStateHelper.
-   *
-   * \param state
-   */
-  AntennaListenerState (ns3::WifiPhyStateHelper *state)
-    : m_state (state)
-  {
-  }
-  virtual ~AntennaListenerState ()
-  {
-  }
-  virtual void NotifyChangeAntennaMode (int mode)
-  {
-    m_state->NotifyChangeAntennaModeNow (mode);
-  }
-private:
-  ns3::WifiPhyStateHelper *m_state;  //!< WifiPhyStateHelper to forward events to
-};
-
 TypeId
 WifiPhyStateHelper::GetTypeId (void)
 {
@@ -83,10 +59,9 @@ WifiPhyStateHelper::WifiPhyStateHelper ()
     m_startRx (Seconds (0)),
     m_startSwitching (Seconds (0)),
     m_previousStateChangeTime (Seconds (0)),
-    m_antennaMode (WifiSwitchedBeamAntennaModel::OMNI),
-    m_antennaListener (0)
+    m_antennaState (Create<WifiAntennaState> ())
 {
-  for(int i = 0; i < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
+  for(int i = 0; i < WifiAntennaModel::MAX_ANTENNA_MODES; i++){
     m_startCcaBusy[i] = Seconds (0);
     m_endCcaBusy[i] = Seconds (0);
   }
@@ -162,7 +137,7 @@ WifiPhyStateHelper::GetDelayUntilIdle (void)
       retval = m_endTx - Simulator::Now ();
       break;
     case WifiPhy::CCA_BUSY:
-      retval = m_endCcaBusy[m_antennaMode] - Simulator::Now ();
+      retval = m_endCcaBusy[m_antennaState->mode] - Simulator::Now ();
       break;
     case WifiPhy::SWITCHING:
       retval = m_endSwitching - Simulator::Now ();
@@ -187,6 +162,12 @@ WifiPhyStateHelper::GetLastRxStartTime (void) const
 
 enum WifiPhy::State
 WifiPhyStateHelper::GetState (void)
+{
+  return GetState (m_antennaState->mode);
+}
+
+enum WifiPhy::State
+WifiPhyStateHelper::GetState (int mode)
 {
   if (m_endTx > Simulator::Now ())
     {
@@ -200,7 +181,7 @@ WifiPhyStateHelper::GetState (void)
     {
       return WifiPhy::SWITCHING;
     }
-  else if (m_endCcaBusy[m_antennaMode] > Simulator::Now ())
+  else if (m_endCcaBusy[mode] > Simulator::Now ())
     {
       return WifiPhy::CCA_BUSY;
     }
@@ -252,6 +233,14 @@ WifiPhyStateHelper::NotifyMaybeCcaBusyStart (Time duration)
     }
 }
 void
+WifiPhyStateHelper::NotifyMaybeCcaBusyStart (Time duration, int mode)
+{
+  for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
+    {
+      (*i)->NotifyMaybeCcaBusyStartForMode (duration, mode);
+    }
+}
+void
 WifiPhyStateHelper::NotifySwitchingStart (Time duration)
 {
   for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
@@ -262,18 +251,24 @@ WifiPhyStateHelper::NotifySwitchingStart (Time duration)
 
 void
 WifiPhyStateHelper::LogPreviousIdleAndCcaBusyStates (void)
+{
+  LogPreviousIdleAndCcaBusyStates (m_antennaState->mode);
+}
+
+void
+WifiPhyStateHelper::LogPreviousIdleAndCcaBusyStates (int mode)
 {
   Time now = Simulator::Now ();
-  Time idleStart = Max (m_endCcaBusy[m_antennaMode], m_endRx);
+  Time idleStart = Max (m_endCcaBusy[mode], m_endRx);
   idleStart = Max (idleStart, m_endTx);
   idleStart = Max (idleStart, m_endSwitching);
   NS_ASSERT (idleStart <= now);
-  if (m_endCcaBusy[m_antennaMode] > m_endRx
-      && m_endCcaBusy[m_antennaMode] > m_endSwitching
-      && m_endCcaBusy[m_antennaMode] > m_endTx)
+  if (m_endCcaBusy[mode] > m_endRx
+      && m_endCcaBusy[mode] > m_endSwitching
+      && m_endCcaBusy[mode] > m_endTx)
     {
       Time ccaBusyStart = Max (m_endTx, m_endRx);
-      ccaBusyStart = Max (ccaBusyStart, m_startCcaBusy[m_antennaMode]);
+      ccaBusyStart = Max (ccaBusyStart, m_startCcaBusy[mode]);
       ccaBusyStart = Max (ccaBusyStart, m_endSwitching);
       m_stateLogger (ccaBusyStart, idleStart - ccaBusyStart, WifiPhy::CCA_BUSY);
     }
@@ -300,7 +295,7 @@ WifiPhyStateHelper::SwitchToTx (Time txDuration, Ptr<const Packet> packet, WifiM
     case WifiPhy::CCA_BUSY:
       {
         Time ccaStart = Max (m_endRx, m_endTx);
-        ccaStart = Max (ccaStart, m_startCcaBusy[m_antennaMode]);
+        ccaStart = Max (ccaStart, m_startCcaBusy[m_antennaState->mode]);
         ccaStart = Max (ccaStart, m_endSwitching);
         m_stateLogger (ccaStart, now - ccaStart, WifiPhy::CCA_BUSY);
       } break;
@@ -333,7 +328,7 @@ WifiPhyStateHelper::SwitchToRx (Time rxDuration)
     case WifiPhy::CCA_BUSY:
       {
         Time ccaStart = Max (m_endRx, m_endTx);
-        ccaStart = Max (ccaStart, m_startCcaBusy[m_antennaMode]);
+        ccaStart = Max (ccaStart, m_startCcaBusy[m_antennaState->mode]);
         ccaStart = Max (ccaStart, m_endSwitching);
         m_stateLogger (ccaStart, now - ccaStart, WifiPhy::CCA_BUSY);
       } break;
@@ -369,7 +364,7 @@ WifiPhyStateHelper::SwitchToChannelSwitching (Time switchingDuration)
     case WifiPhy::CCA_BUSY:
       {
         Time ccaStart = Max (m_endRx, m_endTx);
-        ccaStart = Max (ccaStart, m_startCcaBusy[m_antennaMode]);
+        ccaStart = Max (ccaStart, m_startCcaBusy[m_antennaState->mode]);
         ccaStart = Max (ccaStart, m_endSwitching);
         m_stateLogger (ccaStart, now - ccaStart, WifiPhy::CCA_BUSY);
       } break;
@@ -383,9 +378,9 @@ WifiPhyStateHelper::SwitchToChannelSwitching (Time switchingDuration)
       break;
     }
 
-  if (now < m_endCcaBusy[m_antennaMode])
+  if (now < m_endCcaBusy[m_antennaState->mode])
     {
-      m_endCcaBusy[m_antennaMode] = now;
+      m_endCcaBusy[m_antennaState->mode] = now;
     }
 
   m_stateLogger (now, switchingDuration, WifiPhy::SWITCHING);
@@ -435,14 +430,20 @@ WifiPhyStateHelper::DoSwitchFromRx (void)
 void
 WifiPhyStateHelper::SwitchMaybeToCcaBusy (Time duration)
 {
-  NotifyMaybeCcaBusyStart (duration);
+  SwitchMaybeToCcaBusy (duration, m_antennaState->mode);
+}
+
+void
+WifiPhyStateHelper::SwitchMaybeToCcaBusy (Time duration, int mode)
+{
+  NotifyMaybeCcaBusyStart (duration, mode);
   Time now = Simulator::Now ();
-  switch (GetState ())
+  switch (GetState (mode))
     {
     case WifiPhy::SWITCHING:
       break;
     case WifiPhy::IDLE:
-      LogPreviousIdleAndCcaBusyStates ();
+      LogPreviousIdleAndCcaBusyStates (mode);
       break;
     case WifiPhy::CCA_BUSY:
       break;
@@ -451,31 +452,20 @@ WifiPhyStateHelper::SwitchMaybeToCcaBusy (Time duration)
     case WifiPhy::TX:
       break;
     }
-  if (GetState () != WifiPhy::CCA_BUSY)
+  if (GetState (mode) != WifiPhy::CCA_BUSY)
     {
-      m_startCcaBusy[m_antennaMode] = now;
+      m_startCcaBusy[mode] = now;
     }
-  m_endCcaBusy[m_antennaMode] = std::max (m_endCcaBusy[m_antennaMode], now + duration);
+  m_endCcaBusy[mode] = std::max (m_endCcaBusy[mode], now + duration);
 
-  NS_LOG_DEBUG ("CcaBusy start:" << m_startCcaBusy[m_antennaMode] << ", CcaBusy end:" << m_endCcaBusy[m_antennaMode]);
+  NS_LOG_DEBUG ("CcaBusy start:" << m_startCcaBusy[mode] << ", CcaBusy end:" << m_endCcaBusy[mode]);
 }
 
 void
-WifiPhyStateHelper::SetupAntennaListener (Ptr<WifiAntennaModel> antenna)
+WifiPhyStateHelper::SetupAntennaState (Ptr<WifiAntennaModel> antenna)
 {
   NS_LOG_FUNCTION (this << antenna);
-  if (m_antennaListener != 0)
-    {
-      delete m_antennaListener;
-    }
-  m_antennaListener = new AntennaListenerState (this);
-  antenna->RegisterListener (m_antennaListener);
-}
-void
-WifiPhyStateHelper::NotifyChangeAntennaModeNow (int mode)
-{
-  //  NS_LOG_FUNCTION (this << mode);
-  m_antennaMode = mode;
+  m_antennaState = antenna->GetState ();
 }
 
 } // namespace ns3
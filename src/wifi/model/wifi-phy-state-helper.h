@@ -28,7 +28,6 @@
 
 namespace ns3 {
 
-class AntennaListenerState;
 
 /**
  * \ingroup wifi
@@ -165,9 +164,22 @@ public:
    * \param duration the duration of CCA busy state
    */
   void SwitchMaybeToCcaBusy (Time duration);
+  /**
+   * Switch to CCA busy in the given antenna mode, whether or not
+   * it is the current one.
+   *
+   * \param duration the duration of CCA busy state
+   * \param mode the antenna mode
+   */
+  void SwitchMaybeToCcaBusy (Time duration, int mode);
 
-  void SetupAntennaListener (Ptr<WifiAntennaModel> antenna);
-  void NotifyChangeAntennaModeNow (int mode);
+  /**
+   * Share the mode of the antenna, which selects the per-mode CCA
+   * busy state.
+   *
+   * \param antenna the antenna of the PHY
+   */
+  void SetupAntennaState (Ptr<WifiAntennaModel> antenna);
 
   TracedCallback<Time,Time,enum WifiPhy::State> m_stateLogger;
 private:
@@ -176,10 +188,23 @@ private:
    */
   typedef std::vector<WifiPhyListener *> Listeners;
 
+  /**
+   * Return the state of WifiPhy as seen in the given antenna mode.
+   *
+   * \param mode the antenna mode
+   * \return the state of WifiPhy in that mode
+   */
+  enum WifiPhy::State GetState (int mode);
   /**
    * Log the ideal and CCA states.
    */
   void LogPreviousIdleAndCcaBusyStates (void);
+  /**
+   * Log the ideal and CCA states of the given antenna mode.
+   *
+   * \param mode the antenna mode
+   */
+  void LogPreviousIdleAndCcaBusyStates (int mode);
 
   /**
    * Notify all WifiPhyListener that the transmission has started for the given duration.
@@ -208,6 +233,14 @@ private:
    * \param duration the duration of the CCA state
    */
   void NotifyMaybeCcaBusyStart (Time duration);
+  /**
+   * Notify all WifiPhyListener that the CCA has started for the given
+   * duration in the given antenna mode.
+   *
+   * \param duration the duration of the CCA state
+   * \param mode the antenna mode
+   */
+  void NotifyMaybeCcaBusyStart (Time duration, int mode);
   /**
    * Notify all WifiPhyListener that we are switching channel with the given channel
    * switching delay.
@@ -223,15 +256,14 @@ private:
   bool m_rxing;
   Time m_endTx;
   Time m_endRx;
-  Time m_endCcaBusy[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
+  Time m_endCcaBusy[WifiAntennaModel::MAX_ANTENNA_MODES];
   Time m_endSwitching;
   Time m_startTx;
   Time m_startRx;
-  Time m_startCcaBusy[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
+  Time m_startCcaBusy[WifiAntennaModel::MAX_ANTENNA_MODES];
   Time m_startSwitching;
   Time m_previousStateChangeTime;
-  int m_antennaMode;
-  AntennaListenerState* m_antennaListener;
+  Ptr<WifiAntennaState> m_antennaState; //!< Shared with the antenna and the MAC
 
   Listeners m_listeners;
   TracedCallback<Ptr<const Packet>, double, WifiMode, enum WifiPreamble> m_rxOkTrace;
@@ -46,6 +46,12 @@ WifiPhyListener::~WifiPhyListener ()
 {
 }
 
+void
+WifiPhyListener::NotifyMaybeCcaBusyStartForMode (Time duration, int mode)
+{
+  NotifyMaybeCcaBusyStart (duration);
+}
+
 /****************************************************************
  *       The actual WifiPhy class
  ****************************************************************/
@@ -449,6 +455,50 @@ WifiPhy::CalculateTxDuration (uint32_t size, WifiTxVector txvector, WifiPreamble
   return MicroSeconds (duration);
 }
 
+bool
+WifiPhy::TxDurationKey::operator < (const TxDurationKey &o) const
+{
+  if (size != o.size)
+    {
+      return size < o.size;
+    }
+  if (modeUid != o.modeUid)
+    {
+      return modeUid < o.modeUid;
+    }
+  if (preamble != o.preamble)
+    {
+      return preamble < o.preamble;
+    }
+  if (nss != o.nss)
+    {
+      return nss < o.nss;
+    }
+  if (ness != o.ness)
+    {
+      return ness < o.ness;
+    }
+  return stbc < o.stbc;
+}
+
+Time
+WifiPhy::GetTxDuration (uint32_t size, WifiTxVector txvector, WifiPreamble preamble) const
+{
+  TxDurationKey key;
+  key.size = size;
+  key.modeUid = txvector.GetMode ().GetUid ();
+  key.preamble = preamble;
+  key.nss = txvector.GetNss ();
+  key.ness = txvector.GetNess ();
+  key.stbc = txvector.IsStbc ();
+  TxDurations::iterator it = m_txDurations.lower_bound (key);
+  if (it == m_txDurations.end () || key < it->first)
+    {
+      it = m_txDurations.insert (it, std::make_pair (key, CalculateTxDuration (size, txvector, preamble)));
+    }
+  return it->second;
+}
+
 
 
 void
@@ -22,6 +22,7 @@
 #define WIFI_PHY_H
 
 #include <stdint.h>
+#include <map>
 #include "ns3/callback.h"
 #include "ns3/packet.h"
 #include "ns3/object.h"
@@ -102,6 +103,15 @@ public:
    * what duration it reported.
    */
   virtual void NotifyMaybeCcaBusyStart (Time duration) = 0;
+  /**
+   * \param duration the expected busy duration.
+   * \param mode the antenna mode the medium is busy in.
+   *
+   * Same as NotifyMaybeCcaBusyStart, but the report applies to the
+   * given antenna mode, which need not be the current one. The
+   * default forwards to NotifyMaybeCcaBusyStart.
+   */
+  virtual void NotifyMaybeCcaBusyStartForMode (Time duration, int mode);
   /**
    * \param duration the expected channel switching duration.
    *
@@ -262,6 +272,17 @@ public:
    *          the transmission of these bytes.
    */
   static Time CalculateTxDuration (uint32_t size, WifiTxVector txvector, enum WifiPreamble preamble);
+  /**
+   * \param size the number of bytes in the packet to send
+   * \param txvector the transmission parameters used for this packet
+   * \param preamble the type of preamble to use for this packet.
+   * \return the same as CalculateTxDuration
+   *
+   * The durations already computed by this PHY are remembered, so
+   * that the frame sizes and modes used over and over again by the
+   * MAC are only computed once.
+   */
+  Time GetTxDuration (uint32_t size, WifiTxVector txvector, enum WifiPreamble preamble) const;
 
 /** 
    * \param payloadMode the WifiMode use for the transmission of the payload
@@ -490,6 +511,18 @@ public:
   virtual Ptr<WifiAntennaModel> GetAntenna (void) const = 0;
   virtual Ptr<GeographyTable> GetGeographyTable (void) const = 0;
   virtual Ptr<Object> GetMobility (void) = 0;
+  /**
+   * Same as GetMobility ()->GetObject<MobilityModel> (), without
+   * walking the aggregates of the mobility object on every call.
+   *
+   * \return the mobility model of this PHY, or 0 if it has none yet
+   */
+  virtual MobilityModel *PeekMobilityModel (void) const = 0;
+  /**
+   * \return the id of the node of the device of this PHY, or
+   * 0xffffffff if it has no device attached to a node yet
+   */
+  virtual uint32_t GetNodeId (void) const = 0;
 
   /**
    * Return a WifiMode for DSSS at 1Mbps.
@@ -1069,6 +1102,23 @@ public:
   virtual void SetChannelBonding (bool channelbonding) = 0 ;
 
 private:
+  /**
+   * What the duration of a frame depends on.
+   */
+  struct TxDurationKey
+  {
+    uint32_t size;
+    uint32_t modeUid;
+    uint8_t preamble;
+    uint8_t nss;
+    uint8_t ness;
+    bool stbc;
+    bool operator < (const TxDurationKey &o) const;
+  };
+  typedef std::map<TxDurationKey, Time> TxDurations;
+
+  mutable TxDurations m_txDurations; //!< Durations computed by GetTxDuration
+
   /**
    * The trace source fired when a packet begins the transmission process on
    * the medium.
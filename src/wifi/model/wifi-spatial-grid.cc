@@ -0,0 +1,184 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "wifi-spatial-grid.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE ("WifiSpatialGrid");
+
+namespace ns3 {
+
+WifiSpatialGrid::WifiSpatialGrid ()
+  : m_cellSize (100.0)
+{
+}
+
+void
+WifiSpatialGrid::SetCellSize (double size)
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT (size > 0);
+  m_cellSize = size;
+  m_cells.clear ();
+  for (uint32_t id = 0; id < m_entries.size (); id++)
+    {
+      if (m_entries[id].present)
+        {
+          m_entries[id].key = GetKey (m_entries[id].position);
+          AddToCell (id, m_entries[id].key);
+        }
+    }
+}
+
+double
+WifiSpatialGrid::GetCellSize (void) const
+{
+  return m_cellSize;
+}
+
+WifiSpatialGrid::CellKey
+WifiSpatialGrid::GetKey (const Vector &position) const
+{
+  return std::make_pair (static_cast<int64_t> (std::floor (position.x / m_cellSize)),
+                         static_cast<int64_t> (std::floor (position.y / m_cellSize)));
+}
+
+void
+WifiSpatialGrid::AddToCell (uint32_t id, const CellKey &key)
+{
+  m_cells[key].push_back (id);
+}
+
+void
+WifiSpatialGrid::RemoveFromCell (uint32_t id, const CellKey &key)
+{
+  Cells::iterator it = m_cells.find (key);
+  NS_ASSERT (it != m_cells.end ());
+  Cell &cell = it->second;
+  for (Cell::iterator i = cell.begin (); i != cell.end (); i++)
+    {
+      if (*i == id)
+        {
+          *i = cell.back ();
+          cell.pop_back ();
+          break;
+        }
+    }
+  if (cell.empty ())
+    {
+      m_cells.erase (it);
+    }
+}
+
+void
+WifiSpatialGrid::Update (uint32_t id, const Vector &position)
+{
+  NS_LOG_FUNCTION (this << id << position);
+  if (id >= m_entries.size ())
+    {
+      Entry empty;
+      empty.present = false;
+      m_entries.resize (id + 1, empty);
+    }
+  Entry &entry = m_entries[id];
+  CellKey key = GetKey (position);
+  if (!entry.present)
+    {
+      AddToCell (id, key);
+    }
+  else if (entry.key != key)
+    {
+      RemoveFromCell (id, entry.key);
+      AddToCell (id, key);
+    }
+  entry.present = true;
+  entry.key = key;
+  entry.position = position;
+}
+
+void
+WifiSpatialGrid::Remove (uint32_t id)
+{
+  NS_LOG_FUNCTION (this << id);
+  if (!Contains (id))
+    {
+      return;
+    }
+  RemoveFromCell (id, m_entries[id].key);
+  m_entries[id].present = false;
+}
+
+bool
+WifiSpatialGrid::Contains (uint32_t id) const
+{
+  return id < m_entries.size () && m_entries[id].present;
+}
+
+void
+WifiSpatialGrid::Clear (void)
+{
+  m_cells.clear ();
+  m_entries.clear ();
+}
+
+void
+WifiSpatialGrid::AppendCell (const Cell &cell, const Vector &center, double radius,
+                             std::vector<uint32_t> &ids) const
+{
+  for (Cell::const_iterator i = cell.begin (); i != cell.end (); i++)
+    {
+      if (CalculateDistance (m_entries[*i].position, center) <= radius)
+        {
+          ids.push_back (*i);
+        }
+    }
+}
+
+void
+WifiSpatialGrid::Query (const Vector &center, double radius, std::vector<uint32_t> &ids) const
+{
+  NS_LOG_FUNCTION (this << center << radius);
+  CellKey low = GetKey (Vector (center.x - radius, center.y - radius, 0));
+  CellKey high = GetKey (Vector (center.x + radius, center.y + radius, 0));
+  double nCells = (static_cast<double> (high.first - low.first) + 1)
+    * (static_cast<double> (high.second - low.second) + 1);
+  if (nCells > m_cells.size ())
+    {
+      // the query box covers more cells than are occupied: walking
+      // the occupied cells is cheaper than probing every box cell.
+      for (Cells::const_iterator it = m_cells.begin (); it != m_cells.end (); it++)
+        {
+          if (it->first.first >= low.first && it->first.first <= high.first
+              && it->first.second >= low.second && it->first.second <= high.second)
+            {
+              AppendCell (it->second, center, radius, ids);
+            }
+        }
+      return;
+    }
+  for (int64_t x = low.first; x <= high.first; x++)
+    {
+      Cells::const_iterator it = m_cells.lower_bound (std::make_pair (x, low.second));
+      while (it != m_cells.end () && it->first.first == x && it->first.second <= high.second)
+        {
+          AppendCell (it->second, center, radius, ids);
+          it++;
+        }
+    }
+}
+
+} // namespace ns3
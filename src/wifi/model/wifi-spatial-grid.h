@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef WIFI_SPATIAL_GRID_H
+#define WIFI_SPATIAL_GRID_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include <utility>
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ * \brief uniform grid over the x-y plane used to find nearby PHYs
+ *
+ * Entries are identified by a small integer (the index of the PHY
+ * in the channel's PHY list) and bucketed by the cell containing
+ * their position. The z coordinate is ignored for bucketing, so
+ * a query may return entries which are farther away than the
+ * requested radius in 3D but never misses one which is closer.
+ */
+class WifiSpatialGrid
+{
+public:
+  WifiSpatialGrid ();
+
+  /**
+   * Set the edge length of a grid cell. Existing entries are
+   * re-bucketed.
+   *
+   * \param size the edge length of a cell (m), must be positive
+   */
+  void SetCellSize (double size);
+  /**
+   * \return the edge length of a grid cell (m)
+   */
+  double GetCellSize (void) const;
+
+  /**
+   * Insert the entry, or move it if it is already present.
+   *
+   * \param id the entry identifier
+   * \param position the current position of the entry
+   */
+  void Update (uint32_t id, const Vector &position);
+  /**
+   * Remove the entry. Nothing happens if it is not present.
+   *
+   * \param id the entry identifier
+   */
+  void Remove (uint32_t id);
+  /**
+   * \param id the entry identifier
+   * \return true if the entry is present in the grid
+   */
+  bool Contains (uint32_t id) const;
+  /**
+   * Remove all entries.
+   */
+  void Clear (void);
+
+  /**
+   * Append to ids every entry whose stored position lies within
+   * radius of center. The order of the appended entries is unspecified.
+   *
+   * \param center the center of the query
+   * \param radius the query radius (m)
+   * \param ids the vector the matching entries are appended to
+   */
+  void Query (const Vector &center, double radius, std::vector<uint32_t> &ids) const;
+
+private:
+  typedef std::pair<int64_t, int64_t> CellKey;
+  typedef std::vector<uint32_t> Cell;
+  typedef std::map<CellKey, Cell> Cells;
+
+  struct Entry
+  {
+    bool present;
+    CellKey key;
+    Vector position;
+  };
+
+  CellKey GetKey (const Vector &position) const;
+  void AddToCell (uint32_t id, const CellKey &key);
+  void RemoveFromCell (uint32_t id, const CellKey &key);
+  void AppendCell (const Cell &cell, const Vector &center, double radius,
+                   std::vector<uint32_t> &ids) const;
+
+  double m_cellSize;
+  Cells m_cells;
+  std::vector<Entry> m_entries;
+};
+
+} // namespace ns3
+
+#endif /* WIFI_SPATIAL_GRID_H */
@@ -24,6 +24,9 @@
 #include "ns3/node.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/constant-position-mobility-model.h"
 #include "ns3/object-factory.h"
 #include "yans-wifi-channel.h"
 #include "yans-wifi-phy.h"
@@ -33,6 +36,9 @@
 #include "ns3/wifi-antenna-model.h"
 #include "ns3/wifi-cosine-antenna-model.h"
 #include "ns3/orientation-model.h"
+#include "ns3/wifi-pair-geometry.h"
+#include <algorithm>
+#include <limits>
 
 NS_LOG_COMPONENT_DEFINE ("YansWifiChannel");
 
@@ -54,117 +60,211 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("SpatialIndex",
+                   "If true, only the receivers which may be reached by a transmission are "
+                   "considered by Send. Requires a deterministic propagation loss model.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_spatialIndexEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SpatialIndexCellSize",
+                   "The cell size (m) of the spatial index. If zero, the cutoff range "
+                   "of the first transmission is used.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_spatialIndexCellSize),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("SpatialIndexCutoff",
+                   "Receivers at which the received power (dBm), with the best possible antenna "
+                   "gains, is below this value do not receive the transmission at all.",
+                   DoubleValue (-110.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_spatialIndexCutoffDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("LinkBudgetCache",
+                   "If true, the path loss and propagation delay of each pair of PHYs is "
+                   "reused until either node changes course. Requires deterministic "
+                   "propagation loss and delay models.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_linkBudgetCacheEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("GeographyOracle",
+                   "If true, the PHYs share a geography table which reads the positions of the "
+                   "nodes from their mobility models, and only CTS and ACK frames, which have no "
+                   "transmitter address to look up, carry a geography tag.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::SetGeographyOracle,
+                                        &YansWifiChannel::GetGeographyOracle),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 YansWifiChannel::YansWifiChannel ()
+  : m_spatialIndexEnabled (false),
+    m_spatialIndexCellSize (0.0),
+    m_spatialIndexCutoffDbm (-110.0),
+    m_spatialIndexValid (false),
+    m_cellSizeChosen (false),
+    m_maxRxGainDb (0.0),
+    m_linkBudgetCacheEnabled (false)
 {
 }
 YansWifiChannel::~YansWifiChannel ()
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_phyList.clear ();
+  m_geographyOracle = 0;
 }
 
 void
 YansWifiChannel::SetPropagationLossModel (Ptr<PropagationLossModel> loss)
 {
   m_loss = loss;
+  m_cutoffRanges.clear ();
+  m_linkBudgetCache.Clear ();
 }
 void
 YansWifiChannel::SetPropagationDelayModel (Ptr<PropagationDelayModel> delay)
 {
   m_delay = delay;
+  m_linkBudgetCache.Clear ();
 }
 
 void
 YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm,
-                       WifiTxVector txVector, WifiPreamble preamble) const
+                       WifiTxVector txVector, WifiPreamble preamble, Time txDuration) const
 {
-  Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
+  // the mobility models are wrapped in a Ptr only where a propagation
+  // model needs one, which the link budget cache mostly avoids
+  MobilityModel *senderMobility = sender->PeekMobilityModel ();
   NS_ASSERT (senderMobility != 0);
-  uint32_t j = 0;
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+  uint32_t senderIndex = 0;
+  if (m_linkBudgetCacheEnabled)
     {
-      if (sender != (*i))
+      TrackMobility ();
+      senderIndex = m_phyIndex.find (PeekPointer (sender))->second;
+    }
+  bool culled = m_spatialIndexEnabled && GatherCandidates (sender, senderMobility, txPowerDbm);
+  Vector senderPosition = senderMobility->GetPosition ();
+  // a constant speed delay only depends on the distance, which the
+  // pair geometry already holds; subclasses may do anything else
+  double delaySpeed = 0;
+  if (m_delay->GetInstanceTypeId () == ConstantSpeedPropagationDelayModel::GetTypeId ())
+    {
+      delaySpeed = DynamicCast<ConstantSpeedPropagationDelayModel> (m_delay)->GetSpeed ();
+    }
+  // first pass: the receivers on our channel number and their
+  // geometry, so that the transmit gains are evaluated in one batch
+  m_batchReceivers.clear ();
+  m_batchGeometries.clear ();
+  m_batchPhi.clear ();
+  m_batchTheta.clear ();
+  uint32_t nCandidates = culled ? m_candidates.size () : m_phyList.size ();
+  for (uint32_t c = 0; c < nCandidates; c++)
+    {
+      uint32_t j = culled ? m_candidates[c] : c;
+      Ptr<YansWifiPhy> receiver = m_phyList[j];
+      // For now don't account for inter channel interference
+      if (sender == receiver || receiver->GetChannelNumber () != sender->GetChannelNumber ())
+        {
+          continue;
+        }
+      m_batchReceivers.push_back (j);
+      m_batchGeometries.push_back (WifiPairGeometry (senderPosition,
+                                                     receiver->PeekMobilityModel ()->GetPosition ()));
+      m_batchPhi.push_back (m_batchGeometries.back ().GetDirection ().phi);
+      m_batchTheta.push_back (m_batchGeometries.back ().GetDirection ().theta);
+    }
+  uint32_t nReceivers = m_batchReceivers.size ();
+  if (nReceivers == 0)
+    {
+      return;
+    }
+  m_batchTxGainDb.assign (nReceivers, 0.0);
+  Ptr<WifiAntennaModel> sendAnt = sender->GetAntenna ();
+  if (sendAnt != 0)
+    {
+      sendAnt->GetGainDb (&m_batchPhi[0], &m_batchTheta[0], nReceivers, &m_batchTxGainDb[0]);
+    }
+  for (uint32_t c = 0; c < nReceivers; c++)
+    {
+      uint32_t j = m_batchReceivers[c];
+      Ptr<YansWifiPhy> receiver = m_phyList[j];
+      const WifiPairGeometry &geometry = m_batchGeometries[c];
+      MobilityModel *receiverMobility = receiver->PeekMobilityModel ();
+      /*
+      double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+      NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                    "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
+      */
+      // [2014/09/07] add sugiyama
+      double txGain = m_batchTxGainDb[c];
+      // the path does not depend on the receive antenna mode:
+      // evaluate it once and add the per-mode gains below.
+      Time delay;
+      double rxPathDbm;
+      double lossDb;
+      bool cacheable = m_linkBudgetCacheEnabled
+        && !m_mobilityStates[senderIndex].moving && !m_mobilityStates[j].moving;
+      if (cacheable
+          && m_linkBudgetCache.Lookup (senderIndex, j,
+                                       m_mobilityStates[senderIndex].epoch,
+                                       m_mobilityStates[j].epoch,
+                                       lossDb, delay))
+        {
+          rxPathDbm = txPowerDbm + txGain - lossDb;
+        }
+      else
         {
-          // For now don't account for inter channel interference
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
+          if (delaySpeed > 0)
             {
-              continue;
+              delay = Seconds (geometry.GetDistance () / delaySpeed);
             }
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          /*
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          */
-          // [2014/09/07] add sugiyama
-          double txGain = 0;
-          Ptr<WifiAntennaModel> sendAnt = sender->GetAntenna ();
-          if(sendAnt != 0){
-            txGain = sendAnt->GetGainDb (senderMobility, receiverMobility);
-          }
-          double *rxPowerDbm = new double[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-          double rxGain[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-          for(int k = 0; k < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; k++){
-            rxPowerDbm[k] = m_loss->CalcRxPower (txPowerDbm + txGain, senderMobility, receiverMobility); 
-            rxGain[k] = 0;
-          }
-          Ptr<WifiAntennaModel> recvAnt = (*i)->GetAntenna ();
-          if(recvAnt != 0){
-            int tmpAntennaMode = recvAnt->GetAntennaMode ();
-            for(int k = 0; k < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; k++){
-              recvAnt->SetAntennaMode (k);
-              rxGain[k] = recvAnt->GetGainDb (receiverMobility, senderMobility);
-              rxPowerDbm[k] += rxGain[k];
-            }
-            recvAnt->SetAntennaMode (tmpAntennaMode);
-          }
-          int k = recvAnt->GetAntennaMode ();
-          NS_LOG_DEBUG ("antennaMode=" << k              << ", "    <<
-                        "txPower="     << txPowerDbm     << "dbm, " <<
-                        "txGain="      << txGain         << "dbm, " <<
-                        "rxGain="      << rxGain[k]      << "dbm, " <<
-                        "rxPowerDbm="  << rxPowerDbm[k]  << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          
-          for(int k = 0; k < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; k++){
-            NS_LOG_DEBUG("rxGain="  << rxGain[k] << "dbm, " << "rxPower=" << rxPowerDbm[k] << "dbm");
-          }
-          // [2014/09/07] end sugiyama
-
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
-          uint32_t dstNode;
-          if (dstNetDevice == 0)
+          else
             {
-              dstNode = 0xffffffff;
+              delay = m_delay->GetDelay (Ptr<MobilityModel> (senderMobility),
+                                         Ptr<MobilityModel> (receiverMobility));
             }
-          else
+          rxPathDbm = m_loss->CalcRxPower (txPowerDbm + txGain, Ptr<MobilityModel> (senderMobility),
+                                           Ptr<MobilityModel> (receiverMobility));
+          if (cacheable)
             {
-              dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
+              m_linkBudgetCache.Insert (senderIndex, j,
+                                        m_mobilityStates[senderIndex].epoch,
+                                        m_mobilityStates[j].epoch,
+                                        txPowerDbm + txGain - rxPathDbm, delay);
             }
-          Simulator::ScheduleWithContext (dstNode,
-                                          delay, &YansWifiChannel::Receive, this,
-                                          j, copy,
-                                          rxPowerDbm,
-                                          txVector, preamble);
         }
-    }
-}
+      // one power per mode of the receiving antenna: a single one
+      // for an antenna without sectors
+      Ptr<WifiAntennaModel> recvAnt = receiver->GetAntenna ();
+      int nModes = recvAnt != 0 ? recvAnt->GetNAntennaModes () : 1;
+      PerModePower rxPowerDbm (nModes, rxPathDbm);
+      double rxGain[WifiAntennaModel::MAX_ANTENNA_MODES];
+      rxGain[0] = 0;
+      if(recvAnt != 0){
+        recvAnt->GetGainsDb (geometry.GetReverseDirection (), rxGain);
+        for(int k = 0; k < nModes; k++){
+          rxPowerDbm[k] += rxGain[k];
+        }
+      }
+      int k = recvAnt != 0 ? recvAnt->GetAntennaMode () : 0;
+      NS_LOG_DEBUG ("antennaMode=" << k              << ", "    <<
+                    "txPower="     << txPowerDbm     << "dbm, " <<
+                    "txGain="      << txGain         << "dbm, " <<
+                    "rxGain="      << rxGain[k]      << "dbm, " <<
+                    "rxPowerDbm="  << rxPowerDbm[k]  << "dbm, " <<
+                    "distance=" << geometry.GetDistance () << "m, delay=" << delay);
+      
+      for(int k = 0; k < nModes; k++){
+        NS_LOG_DEBUG("rxGain="  << rxGain[k] << "dbm, " << "rxPower=" << rxPowerDbm[k] << "dbm");
+      }
+      // [2014/09/07] end sugiyama
 
-void
-YansWifiChannel::Receive (uint32_t i, Ptr<Packet> packet,
-                          double rxPowerDbm[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES],
-                          WifiTxVector txVector, WifiPreamble preamble) const
-{
-  for(int k = 0; k < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; k++){
-    NS_LOG_DEBUG("rxPower=" << rxPowerDbm[k] << "dbm");
-  }
-  m_phyList[i]->StartReceivePacket (packet, rxPowerDbm, txVector, preamble);
+      Ptr<Packet> copy = packet->Copy ();
+      Simulator::ScheduleWithContext (receiver->GetNodeId (),
+                                      delay, &YansWifiPhy::StartReceivePacket, receiver,
+                                      copy, rxPowerDbm,
+                                      txVector, preamble, txDuration);
+    }
 }
 
 uint32_t
@@ -181,7 +281,219 @@ YansWifiChannel::GetDevice (uint32_t i) const
 void
 YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
+  m_phyIndex[PeekPointer (phy)] = m_phyList.size ();
   m_phyList.push_back (phy);
+  m_spatialIndexValid = false;
+  if (m_geographyOracle != 0)
+    {
+      phy->SetGeographyTable (m_geographyOracle);
+    }
+}
+
+void
+YansWifiChannel::SetGeographyOracle (bool enable)
+{
+  NS_LOG_FUNCTION (this << enable);
+  if (enable == (m_geographyOracle != 0))
+    {
+      return;
+    }
+  if (enable)
+    {
+      m_geographyOracle = CreateObject<GeographyOracle> ();
+      m_geographyOracle->SetChannel (this);
+    }
+  else
+    {
+      m_geographyOracle->Dispose ();
+      m_geographyOracle = 0;
+    }
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+    {
+      if (enable)
+        {
+          (*i)->SetGeographyTable (m_geographyOracle);
+        }
+      else
+        {
+          (*i)->SetGeographyTable (CreateObject<GeographyTable> ());
+        }
+    }
+}
+
+bool
+YansWifiChannel::GetGeographyOracle (void) const
+{
+  return m_geographyOracle != 0;
+}
+
+bool
+YansWifiChannel::GatherCandidates (Ptr<YansWifiPhy> sender, const MobilityModel *senderMobility,
+                                   double txPowerDbm) const
+{
+  if (!m_spatialIndexValid)
+    {
+      BuildSpatialIndex ();
+    }
+  double txMaxGainDb = 0;
+  Ptr<WifiAntennaModel> sendAnt = sender->GetAntenna ();
+  if (sendAnt != 0)
+    {
+      txMaxGainDb = sendAnt->GetMaxGainDb ();
+    }
+  double range = GetCutoffRange (txPowerDbm + txMaxGainDb + m_maxRxGainDb);
+  if (range == std::numeric_limits<double>::infinity ())
+    {
+      return false;
+    }
+  if (m_spatialIndexCellSize <= 0 && !m_cellSizeChosen)
+    {
+      m_grid.SetCellSize (std::max (range, 1.0));
+      m_cellSizeChosen = true;
+    }
+  m_candidates.clear ();
+  m_grid.Query (senderMobility->GetPosition (), range, m_candidates);
+  m_candidates.insert (m_candidates.end (), m_movingPhys.begin (), m_movingPhys.end ());
+  // keep the original scheduling order of the receive events
+  std::sort (m_candidates.begin (), m_candidates.end ());
+  NS_LOG_DEBUG ("range=" << range << "m, " << m_candidates.size () << "/" << m_phyList.size () << " receivers");
+  return true;
+}
+
+void
+YansWifiChannel::TrackMobility (void) const
+{
+  for (uint32_t j = m_mobilityStates.size (); j < m_phyList.size (); j++)
+    {
+      MobilityState state;
+      state.mobility = 0;
+      state.epoch = 0;
+      state.moving = true;
+      state.mobility = m_phyList[j]->PeekMobilityModel ();
+      if (state.mobility != 0)
+        {
+          const MobilityModel *key = PeekPointer (state.mobility);
+          if (m_mobilityIndex.find (key) == m_mobilityIndex.end ())
+            {
+              state.mobility->TraceConnectWithoutContext ("CourseChange",
+                                                          MakeCallback (&YansWifiChannel::CourseChanged, this));
+            }
+          m_mobilityIndex.insert (std::make_pair (key, j));
+          Vector velocity = state.mobility->GetVelocity ();
+          state.moving = velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
+        }
+      m_mobilityStates.push_back (state);
+    }
+}
+
+void
+YansWifiChannel::BuildSpatialIndex (void) const
+{
+  NS_LOG_FUNCTION (this);
+  TrackMobility ();
+  m_grid.Clear ();
+  if (m_spatialIndexCellSize > 0)
+    {
+      m_grid.SetCellSize (m_spatialIndexCellSize);
+      m_cellSizeChosen = true;
+    }
+  m_movingPhys.clear ();
+  m_maxRxGainDb = -std::numeric_limits<double>::infinity ();
+  for (uint32_t j = 0; j < m_phyList.size (); j++)
+    {
+      Ptr<YansWifiPhy> phy = m_phyList[j];
+      double rxGainDb = phy->GetRxGain ();
+      if (phy->GetAntenna () != 0)
+        {
+          rxGainDb += phy->GetAntenna ()->GetMaxGainDb ();
+        }
+      m_maxRxGainDb = std::max (m_maxRxGainDb, rxGainDb);
+      UpdateSpatialIndex (j);
+    }
+  m_spatialIndexValid = true;
+}
+
+double
+YansWifiChannel::GetCutoffRange (double eirpDbm) const
+{
+  std::map<double, double>::const_iterator cached = m_cutoffRanges.find (eirpDbm);
+  if (cached != m_cutoffRanges.end ())
+    {
+      return cached->second;
+    }
+  // The loss is assumed not to decrease with distance: look for the
+  // first power of two beyond the cutoff, then bisect down to 1 cm.
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0, 0, 0));
+  double low = 0;
+  double high = 1;
+  double range = std::numeric_limits<double>::infinity ();
+  while (high < 1e7)
+    {
+      b->SetPosition (Vector (high, 0, 0));
+      if (m_loss->CalcRxPower (eirpDbm, a, b) < m_spatialIndexCutoffDbm)
+        {
+          range = high;
+          break;
+        }
+      low = high;
+      high *= 2;
+    }
+  while (range != std::numeric_limits<double>::infinity () && high - low > 0.01)
+    {
+      double middle = (low + high) / 2;
+      b->SetPosition (Vector (middle, 0, 0));
+      if (m_loss->CalcRxPower (eirpDbm, a, b) < m_spatialIndexCutoffDbm)
+        {
+          high = middle;
+        }
+      else
+        {
+          low = middle;
+        }
+      range = high;
+    }
+  NS_LOG_DEBUG ("eirp=" << eirpDbm << "dbm, cutoff range=" << range << "m");
+  m_cutoffRanges[eirpDbm] = range;
+  return range;
+}
+
+void
+YansWifiChannel::UpdateSpatialIndex (uint32_t i) const
+{
+  const MobilityState &state = m_mobilityStates[i];
+  if (state.moving)
+    {
+      // CourseChange does not fire while a node keeps its course,
+      // so a moving node cannot be bucketed.
+      m_grid.Remove (i);
+      m_movingPhys.insert (i);
+    }
+  else
+    {
+      m_movingPhys.erase (i);
+      m_grid.Update (i, state.mobility->GetPosition ());
+    }
+}
+
+void
+YansWifiChannel::CourseChanged (Ptr<const MobilityModel> mobility) const
+{
+  Vector velocity = mobility->GetVelocity ();
+  bool moving = velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
+  std::pair<MobilityIndex::const_iterator, MobilityIndex::const_iterator> phys =
+    m_mobilityIndex.equal_range (PeekPointer (mobility));
+  for (MobilityIndex::const_iterator it = phys.first; it != phys.second; it++)
+    {
+      MobilityState &state = m_mobilityStates[it->second];
+      state.epoch++;
+      state.moving = moving;
+      if (m_spatialIndexValid)
+        {
+          UpdateSpatialIndex (it->second);
+        }
+    }
 }
 
 int64_t
@@ -21,17 +21,25 @@
 #define YANS_WIFI_CHANNEL_H
 
 #include <vector>
+#include <map>
+#include <set>
 #include <stdint.h>
 #include "ns3/packet.h"
 #include "ns3/wifi-antenna-model.h"
+#include "ns3/wifi-pair-geometry.h"
 #include "wifi-channel.h"
 #include "wifi-mode.h"
 #include "wifi-preamble.h"
 #include "wifi-tx-vector.h"
+#include "wifi-spatial-grid.h"
+#include "wifi-link-budget-cache.h"
+#include "per-mode-power.h"
+#include "geography-oracle.h"
 
 namespace ns3 {
 
 class NetDevice;
+class MobilityModel;
 class PropagationLossModel;
 class PropagationDelayModel;
 class YansWifiPhy;
@@ -47,6 +55,26 @@ class YansWifiPhy;
  * class and contains a ns3::PropagationLossModel and a ns3::PropagationDelayModel.
  * By default, no propagation models are set so, it is the caller's responsability
  * to set them before using the channel.
+ *
+ * When the SpatialIndex attribute is enabled, Send only considers the
+ * receivers which lie within the distance at which the received power,
+ * assuming the best possible antenna gains at both ends, can still be
+ * above SpatialIndexCutoff. This requires a deterministic propagation
+ * loss model whose loss does not decrease with distance; receivers
+ * beyond that distance never get the frame, not even as interference.
+ * The index is kept up to date from the CourseChange trace of the
+ * mobility models; nodes which are moving are checked on every Send.
+ *
+ * When the LinkBudgetCache attribute is enabled, the path loss and the
+ * propagation delay of every (sender, receiver) pair are computed once
+ * and reused until either node changes course. Pairs involving a
+ * moving node are never cached. This is only correct for deterministic
+ * propagation loss and delay models.
+ *
+ * When the GeographyOracle attribute is enabled, the PHYs of the
+ * channel share a single GeographyOracle, which reads the positions of
+ * the nodes from their mobility models, instead of each learning them
+ * from the geography tags of the frames it receives.
  */
 class YansWifiChannel : public WifiChannel
 {
@@ -82,6 +110,7 @@ public:
    * \param txPowerDbm the tx power associated to the packet
    * \param txVector the TXVECTOR associated to the packet
    * \param preamble the preamble associated to the packet
+   * \param txDuration the duration of the packet, handed to every receiver
    *
    * This method should not be invoked by normal users. It is
    * currently invoked only from WifiPhy::Send. YansWifiChannel
@@ -89,7 +118,7 @@ public:
    * e.g. PHYs that are operating on the same channel.
    */
   void Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm,
-             WifiTxVector txVector, WifiPreamble preamble) const;
+             WifiTxVector txVector, WifiPreamble preamble, Time txDuration) const;
 
  /**
   * Assign a fixed random variable stream number to the random variables
@@ -101,6 +130,13 @@ public:
   */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * \param enable whether the PHYs share a GeographyOracle instead of
+   * their own geography tables
+   */
+  void SetGeographyOracle (bool enable);
+  bool GetGeographyOracle (void) const;
+
 private:
   //YansWifiChannel& operator = (const YansWifiChannel &);
   //YansWifiChannel (const YansWifiChannel &);
@@ -110,23 +146,83 @@ private:
    */
   typedef std::vector<Ptr<YansWifiPhy> > PhyList;
   /**
-   * This method is scheduled by Send for each associated YansWifiPhy.
-   * The method then calls the corresponding YansWifiPhy that the first
-   * bit of the packet has arrived.
+   * Fill m_candidates with the sorted indices of the PHYs which can
+   * possibly hear a transmission of the sender.
+   *
+   * \param sender the transmitting PHY
+   * \param senderMobility the mobility model of the transmitting PHY
+   * \param txPowerDbm the tx power associated to the packet
+   * \return false if no receiver can be culled, in which case
+   * m_candidates is left untouched
+   */
+  bool GatherCandidates (Ptr<YansWifiPhy> sender, const MobilityModel *senderMobility,
+                         double txPowerDbm) const;
+  /**
+   * Subscribe to the CourseChange trace of the mobility models of the
+   * PHYs added since the last call.
+   */
+  void TrackMobility (void) const;
+  /**
+   * Insert every PHY in the spatial index.
+   */
+  void BuildSpatialIndex (void) const;
+  /**
+   * \param eirpDbm the transmit power plus the best possible antenna gains
+   * \return the distance beyond which the received power is below
+   * SpatialIndexCutoff, or +infinity if there is no such distance.
+   */
+  double GetCutoffRange (double eirpDbm) const;
+  /**
+   * Move the PHY in the spatial index to match its mobility model.
    *
    * \param i index of the corresponding YansWifiPhy in the PHY list
-   * \param packet the packet being sent
-   * \param rxPowerDbm the received power of the packet
-   * \param txVector the TXVECTOR of the packet
-   * \param preamble the type of preamble being used to send the packet
    */
-  void Receive (uint32_t i, Ptr<Packet> packet, double rxPowerDbm[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES],
-                WifiTxVector txVector, WifiPreamble preamble) const;
+  void UpdateSpatialIndex (uint32_t i) const;
+  /**
+   * CourseChange trace sink.
+   *
+   * \param mobility the mobility model which changed course
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility) const;
+
+  /**
+   * What the channel knows about the mobility of one PHY.
+   */
+  struct MobilityState
+  {
+    Ptr<MobilityModel> mobility; //!< 0 if the PHY has no mobility model
+    uint32_t epoch;              //!< Incremented on every course change
+    bool moving;                 //!< Whether the velocity is not zero
+  };
+  typedef std::multimap<const MobilityModel *, uint32_t> MobilityIndex;
 
 
   PhyList m_phyList; //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss; //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay; //!< Propagation delay model
+
+  bool m_spatialIndexEnabled; //!< Whether receivers are culled through the spatial index
+  double m_spatialIndexCellSize; //!< Grid cell size (m), 0 to derive it from the cutoff range
+  double m_spatialIndexCutoffDbm; //!< Received power below which a receiver is culled
+  mutable bool m_spatialIndexValid; //!< Whether m_grid reflects the current PHY list
+  mutable bool m_cellSizeChosen; //!< Whether the cell size of m_grid has been set
+  mutable WifiSpatialGrid m_grid; //!< Positions of the PHYs which are not moving
+  mutable std::set<uint32_t> m_movingPhys; //!< PHYs which are checked on every Send
+  mutable std::vector<MobilityState> m_mobilityStates; //!< Indexed like m_phyList
+  mutable MobilityIndex m_mobilityIndex; //!< Mobility models we are subscribed to
+  mutable double m_maxRxGainDb; //!< Best receive gain of any PHY, antenna included
+  mutable std::map<double, double> m_cutoffRanges; //!< Cutoff range by EIRP
+  mutable std::vector<uint32_t> m_candidates; //!< Scratch list of receivers
+  mutable std::vector<uint32_t> m_batchReceivers; //!< Receivers of the current Send
+  mutable std::vector<WifiPairGeometry> m_batchGeometries; //!< Geometry towards each receiver
+  mutable std::vector<double> m_batchPhi; //!< Azimuth towards each receiver
+  mutable std::vector<double> m_batchTheta; //!< Inclination towards each receiver
+  mutable std::vector<double> m_batchTxGainDb; //!< Transmit gain towards each receiver
+
+  bool m_linkBudgetCacheEnabled; //!< Whether path loss and delay are cached
+  mutable WifiLinkBudgetCache m_linkBudgetCache; //!< Path loss and delay by PHY pair
+  std::map<const YansWifiPhy *, uint32_t> m_phyIndex; //!< Index of each PHY in m_phyList
+  Ptr<GeographyOracle> m_geographyOracle; //!< Shared by the PHYs, 0 if disabled
 };
 
 } // namespace ns3
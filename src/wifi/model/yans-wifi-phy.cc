@@ -34,6 +34,7 @@
 #include "ns3/enum.h"
 #include "ns3/pointer.h"
 #include "ns3/net-device.h"
+#include "ns3/node.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/boolean.h"
 #include "ns3/geography-tag.h"
@@ -108,6 +109,27 @@ YansWifiPhy::GetTypeId (void)
                    MakeDoubleAccessor (&YansWifiPhy::SetRxNoiseFigure,
                                        &YansWifiPhy::GetRxNoiseFigure),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("InterferenceHorizon",
+                   "Interference change points older than this are folded into the "
+                   "accumulated interference power when a new signal arrives and no "
+                   "packet is being received. Should not be shorter than the longest frame.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&YansWifiPhy::SetInterferenceHorizon,
+                                     &YansWifiPhy::GetInterferenceHorizon),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("DiscardNegligibleRx",
+                   "If true, arrivals whose power is negligible in every mode of the antenna "
+                   "are dropped before they are tracked as interference.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiPhy::m_discardNegligibleRx),
+                   MakeBooleanChecker ())
+    .AddAttribute ("NegligibleRxMargin",
+                   "How far (dB) below the noise floor of the receiver the power of an "
+                   "arrival must be to be negligible. Only used if DiscardNegligibleRx is true.",
+                   DoubleValue (30.0),
+                   MakeDoubleAccessor (&YansWifiPhy::SetNegligibleRxMargin,
+                                       &YansWifiPhy::GetNegligibleRxMargin),
+                   MakeDoubleChecker<double> (0.0))
     .AddAttribute ("State", "The state of the PHY layer",
                    PointerValue (),
                    MakePointerAccessor (&YansWifiPhy::m_state),
@@ -163,14 +185,28 @@ YansWifiPhy::GetTypeId (void)
                    MakeBooleanAccessor (&YansWifiPhy::GetChannelBonding,
                                         &YansWifiPhy::SetChannelBonding),
                    MakeBooleanChecker ())
+    .AddTraceSource ("InterferenceHighWater",
+                     "The largest number of interference change points held at once.",
+                     MakeTraceSourceAccessor (&YansWifiPhy::m_interferenceHighWater))
+    .AddTraceSource ("NegligibleRxDiscarded",
+                     "The number of arrivals dropped because their power was negligible.",
+                     MakeTraceSourceAccessor (&YansWifiPhy::m_negligibleRxDiscarded))
     ;
   return tid;
 }
 
 YansWifiPhy::YansWifiPhy ()
   :  m_channelNumber (1),
+    m_mobilityModel (0),
+    m_nodeId (0xffffffff),
     m_endRxEvent (),
-    m_channelStartingFrequency (0)
+    m_channelStartingFrequency (0),
+    m_interferenceHighWater (0),
+    m_discardNegligibleRx (false),
+    m_negligibleRxMarginDb (30.0),
+    m_negligibleRxBandwidth (0),
+    m_negligibleRxDbm (0.0),
+    m_negligibleRxDiscarded (0)
 {
   NS_LOG_FUNCTION (this);
   m_random = CreateObject<UniformRandomVariable> ();
@@ -192,6 +228,7 @@ YansWifiPhy::DoDispose (void)
   m_deviceMcsSet.clear();
   m_device = 0;
   m_mobility = 0;
+  m_mobilityModel = 0;
   m_state = 0;
   m_geo = 0;
 }
@@ -241,6 +278,22 @@ YansWifiPhy::SetRxNoiseFigure (double noiseFigureDb)
 {
   NS_LOG_FUNCTION (this << noiseFigureDb);
   m_interference.SetNoiseFigure (DbToRatio (noiseFigureDb));
+  m_negligibleRxBandwidth = 0;
+}
+void
+YansWifiPhy::SetInterferenceHorizon (Time horizon)
+{
+  NS_LOG_FUNCTION (this << horizon);
+  // a negative horizon would fold change points still in the future
+  NS_ASSERT (!horizon.IsStrictlyNegative ());
+  m_interference.SetHorizon (horizon);
+}
+void
+YansWifiPhy::SetNegligibleRxMargin (double margin)
+{
+  NS_LOG_FUNCTION (this << margin);
+  m_negligibleRxMarginDb = margin;
+  m_negligibleRxBandwidth = 0;
 }
 void
 YansWifiPhy::SetTxPowerStart (double start)
@@ -271,6 +324,7 @@ YansWifiPhy::SetRxGain (double gain)
 {
   NS_LOG_FUNCTION (this << gain);
   m_rxGainDb = gain;
+  m_negligibleRxBandwidth = 0;
 }
 void
 YansWifiPhy::SetEdThreshold (double threshold)
@@ -293,11 +347,13 @@ void
 YansWifiPhy::SetDevice (Ptr<Object> device)
 {
   m_device = device;
+  m_nodeId = 0xffffffff;
 }
 void
 YansWifiPhy::SetMobility (Ptr<Object> mobility)
 {
   m_mobility = mobility;
+  m_mobilityModel = 0;
 }
 
 double
@@ -306,6 +362,16 @@ YansWifiPhy::GetRxNoiseFigure (void) const
   return RatioToDb (m_interference.GetNoiseFigure ());
 }
 double
+YansWifiPhy::GetNegligibleRxMargin (void) const
+{
+  return m_negligibleRxMarginDb;
+}
+Time
+YansWifiPhy::GetInterferenceHorizon (void) const
+{
+  return m_interference.GetHorizon ();
+}
+double
 YansWifiPhy::GetTxPowerStart (void) const
 {
   return m_txPowerBaseDbm;
@@ -353,6 +419,29 @@ YansWifiPhy::GetMobility (void)
 {
   return m_mobility;
 }
+MobilityModel *
+YansWifiPhy::PeekMobilityModel (void) const
+{
+  if (m_mobilityModel == 0 && m_mobility != 0)
+    {
+      // m_mobility keeps the aggregate, hence the model, alive
+      m_mobilityModel = PeekPointer (m_mobility->GetObject<MobilityModel> ());
+    }
+  return m_mobilityModel;
+}
+uint32_t
+YansWifiPhy::GetNodeId (void) const
+{
+  if (m_nodeId == 0xffffffff && m_device != 0)
+    {
+      Ptr<NetDevice> device = m_device->GetObject<NetDevice> ();
+      if (device != 0 && device->GetNode () != 0)
+        {
+          m_nodeId = device->GetNode ()->GetId ();
+        }
+    }
+  return m_nodeId;
+}
 Ptr<WifiAntennaModel>
 YansWifiPhy::GetAntenna (void) const
 {
@@ -363,6 +452,12 @@ YansWifiPhy::GetGeographyTable (void) const
 {
   return m_geo;
 }
+void
+YansWifiPhy::SetGeographyTable (Ptr<GeographyTable> table)
+{
+  NS_LOG_FUNCTION (this << table);
+  m_geo = table;
+}
 
 double
 YansWifiPhy::CalculateSnr (WifiMode txMode, double ber) const
@@ -386,8 +481,8 @@ void
 YansWifiPhy::SetAntenna (Ptr<WifiAntennaModel> antenna)
 {
   m_antenna = antenna;
-  m_state->SetupAntennaListener (m_antenna);
-  m_interference.SetupAntennaListener (m_antenna);
+  m_state->SetupAntennaState (m_antenna);
+  m_interference.SetupAntennaState (m_antenna);
 }
 
 void
@@ -461,22 +556,51 @@ YansWifiPhy::SetReceiveErrorCallback (RxErrorCallback callback)
 {
   m_state->SetReceiveErrorCallback (callback);
 }
+bool
+YansWifiPhy::IsNegligibleRx (const PerModePower &rxPowerDbm, WifiMode mode)
+{
+  if (mode.GetBandwidth () != m_negligibleRxBandwidth)
+    {
+      // the thermal noise floor of InterferenceHelper::CalculateSnr,
+      // referred to the input of the receive gain
+      static const double BOLTZMANN = 1.3803e-23;
+      m_negligibleRxBandwidth = mode.GetBandwidth ();
+      m_negligibleRxDbm = WToDbm (BOLTZMANN * 290.0 * m_negligibleRxBandwidth)
+        + GetRxNoiseFigure () - m_negligibleRxMarginDb - m_rxGainDb;
+    }
+  for (uint32_t i = 0; i < rxPowerDbm.GetNModes (); i++)
+    {
+      if (rxPowerDbm[i] >= m_negligibleRxDbm)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
 void
 YansWifiPhy::StartReceivePacket (Ptr<Packet> packet,
-                                 double rxPowerDbm[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES],
+                                 const PerModePower &rxPowerDbm,
                                  WifiTxVector txVector,
-                                 enum WifiPreamble preamble)
+                                 enum WifiPreamble preamble,
+                                 Time rxDuration)
 {
-  NS_LOG_FUNCTION (this << packet << rxPowerDbm << txVector.GetMode()<< preamble);
-  double rxPowerW[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES];
-  for (int i = 0; i < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
+  NS_LOG_FUNCTION (this << packet << txVector.GetMode()<< preamble << rxDuration);
+  if (m_discardNegligibleRx && IsNegligibleRx (rxPowerDbm, txVector.GetMode ()))
+    {
+      NS_LOG_DEBUG ("discard negligible arrival");
+      m_negligibleRxDiscarded++;
+      return;
+    }
+  uint32_t nModes = rxPowerDbm.GetNModes ();
+  PerModePower rxPowerW (nModes, 0.0);
+  for (uint32_t i = 0; i < nModes; i++){
     rxPowerW [i] = DbmToW (rxPowerDbm[i] + m_rxGainDb);
   }
 
-  for(int k = 0; k < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; k++){
+  for(uint32_t k = 0; k < nModes; k++){
     NS_LOG_DEBUG("rxPower=" << rxPowerDbm[k] << "dbm");
   }
-  Time rxDuration = CalculateTxDuration (packet->GetSize (), txVector, preamble);
   WifiMode txMode = txVector.GetMode();
   Time endRx = Simulator::Now () + rxDuration;
 
@@ -487,6 +611,10 @@ YansWifiPhy::StartReceivePacket (Ptr<Packet> packet,
                               rxDuration,
                               rxPowerW,
                               txVector);  // we need it to calculate duration of HT training symbols
+  if (m_interference.GetNPendingChanges () > m_interferenceHighWater)
+    {
+      m_interferenceHighWater = m_interference.GetNPendingChanges ();
+    }
 
   switch (m_state->GetState ())
     {
@@ -571,16 +699,15 @@ maybeCcaBusy:
   // not going to be able to synchronize on it
   // In this model, CCA becomes busy when the aggregation of all signals as
   // tracked by the InterferenceHelper class is higher than the CcaBusyThreshold
-  int tmpAntennaMode = m_antenna->GetAntennaMode ();
-  for(int i = 0; i < WifiAntennaModel::NUMBER_OF_ANTENNA_MODES; i++){
-    m_antenna->SetAntennaMode (i);
-    Time delayUntilCcaEnd = m_interference.GetEnergyDuration (m_ccaMode1ThresholdW);
-    if (!delayUntilCcaEnd.IsZero ())
+  int nAntennaModes = m_antenna->GetNAntennaModes ();
+  Time delayUntilCcaEnd[WifiAntennaModel::MAX_ANTENNA_MODES];
+  m_interference.GetEnergyDurations (m_ccaMode1ThresholdW, nAntennaModes, delayUntilCcaEnd);
+  for(int i = 0; i < nAntennaModes; i++){
+    if (!delayUntilCcaEnd[i].IsZero ())
       {
-        m_state->SwitchMaybeToCcaBusy (delayUntilCcaEnd);
+        m_state->SwitchMaybeToCcaBusy (delayUntilCcaEnd[i], i);
       }
   }
-  m_antenna->SetAntennaMode (tmpAntennaMode);
 }
 
 void
@@ -595,7 +722,7 @@ YansWifiPhy::SendPacket (Ptr<const Packet> packet, WifiMode txMode, WifiPreamble
    */
 
   NS_ASSERT (!m_state->IsStateTx () && !m_state->IsStateSwitching ());
-  Time txDuration = CalculateTxDuration (packet->GetSize (), txVector, preamble);
+  Time txDuration = GetTxDuration (packet->GetSize (), txVector, preamble);
   if (m_state->IsStateRx ())
     {
       m_endRxEvent.Cancel ();
@@ -606,7 +733,8 @@ YansWifiPhy::SendPacket (Ptr<const Packet> packet, WifiMode txMode, WifiPreamble
   bool isShortPreamble = (WIFI_PREAMBLE_SHORT == preamble);
   NotifyMonitorSniffTx (packet, (uint16_t)GetChannelFrequencyMhz (), GetChannelNumber (), dataRate500KbpsUnits, isShortPreamble, txVector.GetTxPowerLevel());
   m_state->SwitchToTx (txDuration, packet, txVector.GetMode(), preamble,  txVector.GetTxPowerLevel());
-  m_channel->Send (this, packet, GetPowerDbm ( txVector.GetTxPowerLevel()) + m_txGainDb, txVector, preamble);
+  m_channel->Send (this, packet, GetPowerDbm ( txVector.GetTxPowerLevel()) + m_txGainDb, txVector, preamble,
+                   txDuration);
 }
 
 uint32_t
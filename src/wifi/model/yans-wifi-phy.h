@@ -28,6 +28,7 @@
 #include "ns3/packet.h"
 #include "ns3/object.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include "ns3/random-variable-stream.h"
@@ -107,14 +108,17 @@ public:
    * Starting receiving the packet (i.e. the first bit of the preamble has arrived).
    *
    * \param packet the arriving packet
-   * \param rxPowerDbm the receive power in dBm
+   * \param rxPowerDbm the receive power in dBm of each antenna mode
    * \param txVector the TXVECTOR of the arriving packet
    * \param preamble the preamble of the arriving packet
+   * \param rxDuration the duration of the arriving packet, as computed
+   *        once for all receivers by the transmitter
    */
   void StartReceivePacket (Ptr<Packet> packet,
-                           double rxPowerDbm[WifiAntennaModel::NUMBER_OF_ANTENNA_MODES],
+                           const PerModePower &rxPowerDbm,
                            WifiTxVector txVector,
-                           WifiPreamble preamble);
+                           WifiPreamble preamble,
+                           Time rxDuration);
 
   /**
    * Sets the RX loss (dB) in the Signal-to-Noise-Ratio due to non-idealities in the receiver.
@@ -122,6 +126,20 @@ public:
    * \param noiseFigureDb noise figure in dB
    */
   void SetRxNoiseFigure (double noiseFigureDb);
+  /**
+   * Sets how long interference change points are kept before they
+   * are folded into the accumulated interference power.
+   *
+   * \param horizon the interference history horizon
+   */
+  void SetInterferenceHorizon (Time horizon);
+  /**
+   * Sets how far below the noise floor the power of an arrival must
+   * be, in every antenna mode, for the arrival to be negligible.
+   *
+   * \param margin the margin (dB)
+   */
+  void SetNegligibleRxMargin (double margin);
   /**
    * Sets the minimum available transmission power level (dBm).
    *
@@ -194,6 +212,18 @@ public:
    * \return the RX noise figure in dBm
    */
   double GetRxNoiseFigure (void) const;
+  /**
+   * Return the interference history horizon.
+   *
+   * \return the interference history horizon
+   */
+  Time GetInterferenceHorizon (void) const;
+  /**
+   * Return the margin below the noise floor of negligible arrivals.
+   *
+   * \return the margin (dB)
+   */
+  double GetNegligibleRxMargin (void) const;
   /**
    * Return the transmission gain (dB).
    *
@@ -268,7 +298,16 @@ public:
   virtual Ptr<WifiChannel> GetChannel (void) const;
   virtual Ptr<WifiAntennaModel> GetAntenna (void) const;
   virtual Ptr<GeographyTable> GetGeographyTable (void) const;
+  /**
+   * Replace the geography table of this PHY, e.g., by the oracle shared
+   * by all the PHYs of the channel.
+   *
+   * \param table the new geography table
+   */
+  void SetGeographyTable (Ptr<GeographyTable> table);
   virtual Ptr<Object> GetMobility (void);
+  virtual MobilityModel *PeekMobilityModel (void) const;
+  virtual uint32_t GetNodeId (void) const;
 
   virtual void ConfigureStandard (enum WifiPhyStandard standard);
 
@@ -460,6 +499,14 @@ private:
    * \param event the corresponding event of the first time the packet arrives
    */
   void EndReceive (Ptr<Packet> packet, Ptr<InterferenceHelper::Event> event);
+  /**
+   * \param rxPowerDbm the power of an arrival in each antenna mode,
+   *        without the receive gain
+   * \param mode the mode of the arrival, whose bandwidth sets the noise floor
+   * \return true if the arrival is NegligibleRxMargin below the noise
+   *         floor in every antenna mode
+   */
+  bool IsNegligibleRx (const PerModePower &rxPowerDbm, WifiMode mode);
 
 private:
   double   m_edThresholdW;        //!< Energy detection threshold in watts
@@ -475,6 +522,13 @@ private:
   uint16_t             m_channelNumber;  //!< Operating channel number
   Ptr<Object>          m_device;         //!< Pointer to the device
   Ptr<Object>          m_mobility;       //!< Pointer to the mobility model
+  /**
+   * The MobilityModel aggregated to m_mobility and the node id of
+   * m_device, resolved on first use: both are usually aggregated
+   * after the PHY is configured, and never change once they are.
+   */
+  mutable MobilityModel *m_mobilityModel;
+  mutable uint32_t m_nodeId;
 
   uint32_t m_numberOfTransmitters;  //!< Number of transmitters
   uint32_t m_numberOfReceivers;     //!< Number of receivers
@@ -531,6 +585,12 @@ private:
   double m_channelStartingFrequency;    //!< Standard-dependent center frequency of 0-th channel in MHz
   Ptr<WifiPhyStateHelper> m_state;      //!< Pointer to WifiPhyStateHelper
   InterferenceHelper m_interference;    //!< Pointer to InterferenceHelper
+  TracedValue<uint32_t> m_interferenceHighWater; //!< Most interference change points held at once
+  bool m_discardNegligibleRx;           //!< Whether negligible arrivals are dropped on arrival
+  double m_negligibleRxMarginDb;        //!< Margin below the noise floor of negligible arrivals
+  uint32_t m_negligibleRxBandwidth;     //!< Bandwidth m_negligibleRxDbm is valid for, 0 if none
+  double m_negligibleRxDbm;             //!< Power below which an arrival is negligible
+  TracedValue<uint64_t> m_negligibleRxDiscarded; //!< Number of negligible arrivals dropped
   Time m_channelSwitchDelay;            //!< Time required to switch between channel
 
 };
@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/interference-energy-tracker.h"
+#include "ns3/per-mode-power.h"
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+NS_LOG_COMPONENT_DEFINE ("InterferenceEnergyTrackerTest");
+
+using namespace ns3;
+
+/**
+ * Replay random sequences of signals which start and end, some of them
+ * exactly at the time of the queries, and check that the tracker
+ * returns the durations of a linear scan of the sorted change list,
+ * the way InterferenceHelper computed them before the tracker.
+ */
+class InterferenceEnergyTrackerTestCase : public TestCase
+{
+public:
+  static std::string BuildNameString (uint32_t nModes, uint32_t stream);
+  InterferenceEnergyTrackerTestCase (uint32_t nModes, uint32_t stream);
+
+private:
+  struct Change
+  {
+    Time time;
+    PerModePower delta;
+  };
+  static bool IsEarlier (const Time &time, const Change &change);
+
+  virtual void DoRun (void);
+  /**
+   * Record a change after the changes of the same time, as the
+   * tracker orders them by sequence number.
+   */
+  void AddChange (Time time, const PerModePower &delta);
+  /**
+   * \return the duration the scan of the change list finds
+   */
+  Time ScanEnergyDuration (Time now, double energyW, int mode) const;
+
+  uint32_t m_nModes;
+  uint32_t m_stream;
+  InterferenceEnergyTracker m_tracker;
+  std::vector<Change> m_changes;
+  uint64_t m_nextSeq;
+};
+
+std::string
+InterferenceEnergyTrackerTestCase::BuildNameString (uint32_t nModes, uint32_t stream)
+{
+  std::ostringstream oss;
+  oss << "modes=" << nModes << ", stream=" << stream;
+  return oss.str ();
+}
+
+InterferenceEnergyTrackerTestCase::InterferenceEnergyTrackerTestCase (uint32_t nModes, uint32_t stream)
+  : TestCase (BuildNameString (nModes, stream)),
+    m_nModes (nModes),
+    m_stream (stream),
+    m_nextSeq (0)
+{
+}
+
+bool
+InterferenceEnergyTrackerTestCase::IsEarlier (const Time &time, const Change &change)
+{
+  return time < change.time;
+}
+
+void
+InterferenceEnergyTrackerTestCase::AddChange (Time time, const PerModePower &delta)
+{
+  Change change;
+  change.time = time;
+  change.delta = delta;
+  m_changes.insert (std::upper_bound (m_changes.begin (), m_changes.end (), time, IsEarlier), change);
+  m_tracker.Add (time, m_nextSeq++, delta);
+}
+
+Time
+InterferenceEnergyTrackerTestCase::ScanEnergyDuration (Time now, double energyW, int mode) const
+{
+  double noiseInterferenceW = 0.0;
+  Time end = now;
+  for (std::vector<Change>::const_iterator i = m_changes.begin (); i != m_changes.end (); i++)
+    {
+      noiseInterferenceW += i->delta[mode];
+      end = i->time;
+      if (end < now)
+        {
+          continue;
+        }
+      if (noiseInterferenceW < energyW)
+        {
+          break;
+        }
+    }
+  return end > now ? end - now : MicroSeconds (0);
+}
+
+void
+InterferenceEnergyTrackerTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (m_stream);
+  // powers are small multiples of a power of two, so that the sums are
+  // exact whatever their order and the thresholds can be hit exactly
+  const double unit = 1.0 / (1 << 20);
+
+  Time now = MicroSeconds (0);
+  Time durations[WifiAntennaModel::MAX_ANTENNA_MODES];
+  for (uint32_t step = 0; step < 3000; step++)
+    {
+      // several steps often share a time, for changes to land at now
+      now += MicroSeconds (rng->GetInteger (0, 3));
+      uint32_t action = rng->GetInteger (0, 9);
+      if (action < 5)
+        {
+          // a signal which starts now or a little later; an omni-only
+          // one sometimes, to mix deltas with fewer modes
+          uint32_t nModes = rng->GetInteger (0, 3) == 0 ? 1 : m_nModes;
+          PerModePower power (nModes, 0.0);
+          for (uint32_t k = 0; k < nModes; k++)
+            {
+              power[k] = rng->GetInteger (0, 8) * unit;
+            }
+          Time start = now + MicroSeconds (rng->GetInteger (0, 1) * rng->GetInteger (0, 10));
+          Time end = start + MicroSeconds (rng->GetInteger (1, 30));
+          PerModePower expire (nModes, 0.0);
+          for (uint32_t k = 0; k < nModes; k++)
+            {
+              expire[k] = -power[k];
+            }
+          AddChange (start, power);
+          AddChange (end, expire);
+        }
+      else if (action == 5)
+        {
+          // what InterferenceHelper does on every insertion
+          m_tracker.Advance (now);
+        }
+      else if (action == 6 && rng->GetInteger (0, 49) == 0)
+        {
+          m_tracker.Clear ();
+          m_changes.clear ();
+        }
+      else
+        {
+          double energyW = rng->GetInteger (0, 24) * unit;
+          int mode = rng->GetInteger (0, m_nModes - 1);
+          NS_TEST_EXPECT_MSG_EQ (m_tracker.GetEnergyDuration (now, energyW, mode),
+                                 ScanEnergyDuration (now, energyW, mode),
+                                 "wrong duration at step " << step << " mode=" << mode
+                                                           << " threshold=" << energyW);
+          m_tracker.GetEnergyDurations (now, energyW, m_nModes, durations);
+          for (uint32_t k = 0; k < m_nModes; k++)
+            {
+              NS_TEST_EXPECT_MSG_EQ (durations[k], ScanEnergyDuration (now, energyW, k),
+                                     "wrong batch duration at step " << step << " mode=" << k
+                                                                     << " threshold=" << energyW);
+            }
+        }
+    }
+}
+
+
+class InterferenceEnergyTrackerTestSuite : public TestSuite
+{
+public:
+  InterferenceEnergyTrackerTestSuite ();
+};
+
+InterferenceEnergyTrackerTestSuite::InterferenceEnergyTrackerTestSuite ()
+  : TestSuite ("wifi-interference-energy-tracker", UNIT)
+{
+  AddTestCase (new InterferenceEnergyTrackerTestCase (1, 1), TestCase::QUICK);
+  AddTestCase (new InterferenceEnergyTrackerTestCase (5, 2), TestCase::QUICK);
+  AddTestCase (new InterferenceEnergyTrackerTestCase (5, 3), TestCase::QUICK);
+  AddTestCase (new InterferenceEnergyTrackerTestCase (17, 4), TestCase::QUICK);
+}
+
+static InterferenceEnergyTrackerTestSuite staticInterferenceEnergyTrackerTestSuiteInstance;
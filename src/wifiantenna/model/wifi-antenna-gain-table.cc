@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <ns3/simulator.h>
+#include <cmath>
+#include "wifi-antenna-gain-table.h"
+
+NS_LOG_COMPONENT_DEFINE ("WifiAntennaGainTable");
+
+namespace ns3 {
+
+const double WifiAntennaGainTable::MIN_GAIN_DB = -300.0;
+
+WifiAntennaGainTable::WifiAntennaGainTable (int nModes, uint32_t n)
+  : m_nModes (nModes),
+    m_n (n),
+    m_nTheta (n),
+    m_gains (static_cast<size_t> (nModes) * n * n, 0.0f)
+{
+  NS_ASSERT (nModes > 0 && n > 0);
+}
+
+double
+WifiAntennaGainTable::GetSampleAngle (uint32_t k) const
+{
+  return 2 * M_PI * (static_cast<double> (k) / m_n);
+}
+
+uint32_t
+WifiAntennaGainTable::GetNSamples (void) const
+{
+  return m_n;
+}
+
+uint32_t
+WifiAntennaGainTable::GetNThetaSamples (void) const
+{
+  return m_nTheta;
+}
+
+void
+WifiAntennaGainTable::Set (int mode, uint32_t i, uint32_t j, double gainDb)
+{
+  NS_ASSERT (mode >= 0 && mode < m_nModes && i < m_n && j < m_nTheta);
+  if (!(gainDb > MIN_GAIN_DB))
+    {
+      gainDb = MIN_GAIN_DB;
+    }
+  m_gains[(static_cast<size_t> (mode) * m_nTheta + j) * m_n + i] = static_cast<float> (gainDb);
+}
+
+float
+WifiAntennaGainTable::Get (int mode, uint32_t i, uint32_t j) const
+{
+  return m_gains[(static_cast<size_t> (mode) * m_nTheta + j) * m_n + i];
+}
+
+void
+WifiAntennaGainTable::Compact (void)
+{
+  if (m_nTheta == 1)
+    {
+      return;
+    }
+  for (int mode = 0; mode < m_nModes; mode++)
+    {
+      for (uint32_t j = 1; j < m_nTheta; j++)
+        {
+          for (uint32_t i = 0; i < m_n; i++)
+            {
+              if (Get (mode, i, j) != Get (mode, i, 0))
+                {
+                  return;
+                }
+            }
+        }
+    }
+  std::vector<float> gains (static_cast<size_t> (m_nModes) * m_n);
+  for (int mode = 0; mode < m_nModes; mode++)
+    {
+      for (uint32_t i = 0; i < m_n; i++)
+        {
+          gains[static_cast<size_t> (mode) * m_n + i] = Get (mode, i, 0);
+        }
+    }
+  m_gains.swap (gains);
+  m_nTheta = 1;
+  NS_LOG_LOGIC ("pattern does not depend on the inclination, "
+                << m_gains.size () << " samples kept");
+}
+
+uint32_t
+WifiAntennaGainTable::Wrap (double angle, double &frac) const
+{
+  // dividing by 2*pi first keeps the multiples of pi/4 exact
+  double u = angle / (2 * M_PI) * m_n;
+  double fl = std::floor (u);
+  frac = u - fl;
+  int64_t k = static_cast<int64_t> (fl) % static_cast<int64_t> (m_n);
+  if (k < 0)
+    {
+      k += m_n;
+    }
+  return static_cast<uint32_t> (k);
+}
+
+double
+WifiAntennaGainTable::GetNearest (int mode, double phi, double theta) const
+{
+  double frac;
+  uint32_t i = Wrap (phi, frac);
+  if (frac >= 0.5)
+    {
+      i = (i + 1 == m_n) ? 0 : i + 1;
+    }
+  uint32_t j = 0;
+  if (m_nTheta > 1)
+    {
+      j = Wrap (theta, frac);
+      if (frac >= 0.5)
+        {
+          j = (j + 1 == m_n) ? 0 : j + 1;
+        }
+    }
+  return Get (mode, i, j);
+}
+
+double
+WifiAntennaGainTable::GetInterpolated (int mode, double phi, double theta) const
+{
+  double fi;
+  uint32_t i0 = Wrap (phi, fi);
+  uint32_t i1 = (i0 + 1 == m_n) ? 0 : i0 + 1;
+  if (m_nTheta == 1)
+    {
+      return (1 - fi) * Get (mode, i0, 0) + fi * Get (mode, i1, 0);
+    }
+  double fj;
+  uint32_t j0 = Wrap (theta, fj);
+  uint32_t j1 = (j0 + 1 == m_n) ? 0 : j0 + 1;
+  double g0 = (1 - fi) * Get (mode, i0, j0) + fi * Get (mode, i1, j0);
+  double g1 = (1 - fi) * Get (mode, i0, j1) + fi * Get (mode, i1, j1);
+  return (1 - fj) * g0 + fj * g1;
+}
+
+Ptr<WifiAntennaGainTable>
+WifiAntennaGainTableRegistry::Lookup (const std::string &signature)
+{
+  TableMap::const_iterator it = GetTables ().find (signature);
+  if (it == GetTables ().end ())
+    {
+      return 0;
+    }
+  return it->second;
+}
+
+void
+WifiAntennaGainTableRegistry::Add (const std::string &signature, Ptr<WifiAntennaGainTable> table)
+{
+  NS_LOG_FUNCTION (signature);
+  if (GetTables ().empty ())
+    {
+      // the tables of a simulation go away with it
+      Simulator::ScheduleDestroy (&WifiAntennaGainTableRegistry::Clear);
+    }
+  GetTables ()[signature] = table;
+}
+
+void
+WifiAntennaGainTableRegistry::Clear (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  GetTables ().clear ();
+}
+
+uint32_t
+WifiAntennaGainTableRegistry::GetN (void)
+{
+  return GetTables ().size ();
+}
+
+WifiAntennaGainTableRegistry::TableMap &
+WifiAntennaGainTableRegistry::GetTables (void)
+{
+  static TableMap tables;
+  return tables;
+}
+
+} // namespace ns3
@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef WIFI_ANTENNA_GAIN_TABLE_H
+#define WIFI_ANTENNA_GAIN_TABLE_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <ns3/simple-ref-count.h>
+#include <ns3/ptr.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup antenna
+ *
+ * \brief tabulated radiation pattern of every mode of an antenna
+ *
+ * The pattern of each mode is sampled on a regular grid of N azimuth
+ * and N inclination angles covering [0, 2*pi). Sample k of a row is
+ * taken at 2*pi*(k/N), so that with N a multiple of 8 the multiples of
+ * pi/4, where the sector and beam edges of the models lie, are hit
+ * exactly. Lookups accept any angle and wrap it onto the grid, so the
+ * callers do not have to normalize them.
+ *
+ * When no mode depends on the inclination the table is compacted to
+ * a single inclination row.
+ */
+class WifiAntennaGainTable : public SimpleRefCount<WifiAntennaGainTable>
+{
+public:
+  /**
+   * \param nModes the number of antenna modes
+   * \param n the number of samples over 2*pi of each angle
+   */
+  WifiAntennaGainTable (int nModes, uint32_t n);
+
+  /**
+   * \param k a sample index
+   * \return the angle (radians) of the sample
+   */
+  double GetSampleAngle (uint32_t k) const;
+  /**
+   * \return the number of samples over 2*pi of each angle
+   */
+  uint32_t GetNSamples (void) const;
+  /**
+   * \return the number of inclination rows actually stored
+   */
+  uint32_t GetNThetaSamples (void) const;
+
+  /**
+   * Store a sample. Gains below the floor of the table are clamped to
+   * it, so that interpolation never mixes in an infinity.
+   *
+   * \param mode the antenna mode
+   * \param i the azimuth sample index
+   * \param j the inclination sample index
+   * \param gainDb the gain (dB)
+   */
+  void Set (int mode, uint32_t i, uint32_t j, double gainDb);
+  /**
+   * Drop the inclination dimension if every inclination row holds the
+   * same values. To be called once every sample is set.
+   */
+  void Compact (void);
+
+  /**
+   * \param mode the antenna mode
+   * \param phi the azimuth (radians), any value
+   * \param theta the inclination (radians), any value
+   * \return the gain (dB) of the nearest sample
+   */
+  double GetNearest (int mode, double phi, double theta) const;
+  /**
+   * \param mode the antenna mode
+   * \param phi the azimuth (radians), any value
+   * \param theta the inclination (radians), any value
+   * \return the gain (dB) interpolated between the four surrounding
+   *         samples, or the two surrounding ones once compacted
+   */
+  double GetInterpolated (int mode, double phi, double theta) const;
+
+  /// the lowest gain (dB) a table stores
+  static const double MIN_GAIN_DB;
+
+private:
+  uint32_t Wrap (double angle, double &frac) const;
+  float Get (int mode, uint32_t i, uint32_t j) const;
+
+  int m_nModes;
+  uint32_t m_n;
+  uint32_t m_nTheta;
+  std::vector<float> m_gains; //!< indexed by ((mode * m_nTheta) + j) * m_n + i
+};
+
+/**
+ * \ingroup antenna
+ *
+ * \brief the gain tables shared by the antennas of a simulation
+ *
+ * Antennas whose patterns match look their table up by a signature of
+ * the pattern, so that a scenario in which every node has the same
+ * antenna samples it once. The registry is emptied by
+ * Simulator::Destroy, or by Clear; antennas that already hold a table
+ * keep it until they are destroyed.
+ */
+class WifiAntennaGainTableRegistry
+{
+public:
+  /**
+   * \param signature the signature of the pattern
+   * \return the table registered with that signature, or 0
+   */
+  static Ptr<WifiAntennaGainTable> Lookup (const std::string &signature);
+  /**
+   * \param signature the signature of the pattern
+   * \param table the table sampled from the pattern
+   */
+  static void Add (const std::string &signature, Ptr<WifiAntennaGainTable> table);
+  /**
+   * Release every registered table.
+   */
+  static void Clear (void);
+  /**
+   * \return the number of registered tables
+   */
+  static uint32_t GetN (void);
+
+private:
+  typedef std::map<std::string, Ptr<WifiAntennaGainTable> > TableMap;
+  static TableMap &GetTables (void);
+};
+
+} // namespace ns3
+
+#endif /* WIFI_ANTENNA_GAIN_TABLE_H */
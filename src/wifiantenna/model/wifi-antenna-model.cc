@@ -19,7 +19,13 @@
  */
 
 #include <ns3/log.h>
+#include <ns3/boolean.h>
+#include <ns3/double.h>
+#include <ns3/enum.h>
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <sstream>
 #include "wifi-antenna-model.h"
 #include "ns3/orientation-model.h"
 #include "ns3/antenna-model.h"
@@ -31,20 +37,44 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (WifiAntennaModel);
 
-WifiAntennaListener::~WifiAntennaListener ()
-{
-}
-
 TypeId 
 WifiAntennaModel::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::WifiAntennaModel")
     .SetParent<Object> ()
+    .AddAttribute ("UseGainTable",
+                   "Serve the gains from a table of the radiation pattern of every mode, "
+                   "built on the first query, instead of evaluating the pattern every time.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&WifiAntennaModel::SetUseGainTable,
+                                        &WifiAntennaModel::GetUseGainTable),
+                   MakeBooleanChecker ())
+    .AddAttribute ("GainTableResolution",
+                   "The angular step (degrees) of the gain table, rounded so that "
+                   "45 degrees is a whole number of steps.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&WifiAntennaModel::SetGainTableResolution,
+                                       &WifiAntennaModel::GetGainTableResolution),
+                   MakeDoubleChecker<double> (0.1, 45))
+    .AddAttribute ("GainTableInterpolation",
+                   "How the gain table is read between samples. Nearest keeps the "
+                   "edges of piecewise constant patterns sharp.",
+                   EnumValue (WifiAntennaModel::GAIN_TABLE_LINEAR),
+                   MakeEnumAccessor (&WifiAntennaModel::m_gainTableInterpolation),
+                   MakeEnumChecker (WifiAntennaModel::GAIN_TABLE_NEAREST, "Nearest",
+                                    WifiAntennaModel::GAIN_TABLE_LINEAR, "Linear"))
+    .AddTraceSource ("ModeChange",
+                     "The antenna switched to another mode: the old and the new mode.",
+                     MakeTraceSourceAccessor (&WifiAntennaModel::m_modeChangeTrace))
     ;
   return tid;
 }
 
 WifiAntennaModel::WifiAntennaModel ()
+  : m_state (Create<WifiAntennaState> ()),
+    m_useGainTable (false),
+    m_gainTableResolution (1.0),
+    m_gainTableInterpolation (GAIN_TABLE_LINEAR)
 {
 }
 
@@ -69,6 +99,17 @@ WifiAntennaModel::SetOrientation (const Angles &orientation){
 
 double
 WifiAntennaModel::GetGainDb (Ptr<MobilityModel> src, Ptr<MobilityModel> dest){
+  return GetGainDb (Angles (dest->GetPosition (), src->GetPosition ()));
+}
+
+double
+WifiAntennaModel::GetGainDb (const Angles &direction)
+{
+  if (m_useGainTable)
+    {
+      Angles ori = GetModeOrientation (m_state->mode);
+      return LookupGainDb (direction.phi - ori.phi, direction.theta - ori.theta, m_state->mode);
+    }
   Angles oriSum;
   /*
   Ptr<OrientationModel> antOri = this->GetObject<OrientationModel>();
@@ -81,15 +122,285 @@ WifiAntennaModel::GetGainDb (Ptr<MobilityModel> src, Ptr<MobilityModel> dest){
     oriSum.phi += m_orientation->GetOrientation ().phi;
     oriSum.theta += m_orientation->GetOrientation ().theta;
   }
-  Angles bet(dest->GetPosition(), src->GetPosition());
-  oriSum.phi = NormalizeOverTwoPI(bet.phi - oriSum.phi);
-  oriSum.theta = NormalizeOverTwoPI(bet.theta - oriSum.theta);
+  oriSum.phi = NormalizeOverTwoPI(direction.phi - oriSum.phi);
+  oriSum.theta = NormalizeOverTwoPI(direction.theta - oriSum.theta);
   return DoGetGainDb (oriSum);
 }
 
+double
+WifiAntennaModel::GetGainDb (Ptr<MobilityModel> src, Ptr<MobilityModel> dest, int mode) const
+{
+  Angles ori = GetModeOrientation (mode);
+  Angles bet (dest->GetPosition (), src->GetPosition ());
+  if (m_useGainTable)
+    {
+      return LookupGainDb (bet.phi - ori.phi, bet.theta - ori.theta, mode);
+    }
+  bet.phi = NormalizeOverTwoPI (bet.phi - ori.phi);
+  bet.theta = NormalizeOverTwoPI (bet.theta - ori.theta);
+  return DoGetModeGainDb (bet, mode);
+}
+
+void
+WifiAntennaModel::GetGainsDb (Ptr<MobilityModel> src, Ptr<MobilityModel> dest,
+                              double gains[MAX_ANTENNA_MODES]) const
+{
+  GetGainsDb (Angles (dest->GetPosition (), src->GetPosition ()), gains);
+}
+
+void
+WifiAntennaModel::GetGainsDb (const Angles &direction, double gains[MAX_ANTENNA_MODES]) const
+{
+  // the direction is the same for every mode, only the reference changes
+  int nModes = GetNAntennaModes ();
+  for (int mode = 0; mode < nModes; mode++)
+    {
+      Angles ori = GetModeOrientation (mode);
+      if (m_useGainTable)
+        {
+          gains[mode] = LookupGainDb (direction.phi - ori.phi, direction.theta - ori.theta, mode);
+          continue;
+        }
+      Angles a;
+      a.phi = NormalizeOverTwoPI (direction.phi - ori.phi);
+      a.theta = NormalizeOverTwoPI (direction.theta - ori.theta);
+      gains[mode] = DoGetModeGainDb (a, mode);
+    }
+}
+
+uint32_t
+WifiAntennaModel::GetNAntennaModes (void) const
+{
+  return 1;
+}
+
+Angles
+WifiAntennaModel::GetModeOrientation (int mode) const
+{
+  if (m_orientation == 0)
+    {
+      return Angles ();
+    }
+  return m_orientation->GetOrientation ();
+}
+
+double
+WifiAntennaModel::DoGetModeGainDb (Angles a, int mode) const
+{
+  return DoGetGainDb (a);
+}
+
+void
+WifiAntennaModel::DoGetGainsDb (const double *phi, const double *theta, uint32_t n, double *gains) const
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      gains[i] = DoGetGainDb (Angles (phi[i], theta[i]));
+    }
+}
+
+void
+WifiAntennaModel::DoGetModeGainsDb (const double *phi, const double *theta, uint32_t n, int mode,
+                                    double *gains) const
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      gains[i] = DoGetModeGainDb (Angles (phi[i], theta[i]), mode);
+    }
+}
+
+void
+WifiAntennaModel::SetBatchAngles (const double *phi, const double *theta, uint32_t n,
+                                  const Angles &ori) const
+{
+  if (m_batchPhi.size () < n)
+    {
+      m_batchPhi.resize (n);
+      m_batchTheta.resize (n);
+    }
+  double *relPhi = &m_batchPhi[0];
+  double *relTheta = &m_batchTheta[0];
+  // the angles and the orientation are in [0, 2*pi], so a single turn
+  // is all NormalizeOverTwoPI could ever add
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double p = phi[i] - ori.phi;
+      double t = theta[i] - ori.theta;
+      relPhi[i] = p < 0 ? p + 2 * M_PI : p;
+      relTheta[i] = t < 0 ? t + 2 * M_PI : t;
+    }
+}
+
+void
+WifiAntennaModel::GetGainDb (const double *phi, const double *theta, uint32_t n, double *gains)
+{
+  if (n == 0)
+    {
+      return;
+    }
+  if (m_useGainTable)
+    {
+      Angles ori = GetModeOrientation (m_state->mode);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          gains[i] = LookupGainDb (phi[i] - ori.phi, theta[i] - ori.theta, m_state->mode);
+        }
+      return;
+    }
+  Angles ori;
+  if (m_orientation != 0)
+    {
+      ori = m_orientation->GetOrientation ();
+    }
+  SetBatchAngles (phi, theta, n, ori);
+  DoGetGainsDb (&m_batchPhi[0], &m_batchTheta[0], n, gains);
+}
+
+void
+WifiAntennaModel::GetGainsDb (const double *phi, const double *theta, uint32_t n, double *gains) const
+{
+  if (n == 0)
+    {
+      return;
+    }
+  int nModes = GetNAntennaModes ();
+  for (int mode = 0; mode < nModes; mode++)
+    {
+      Angles ori = GetModeOrientation (mode);
+      double *modeGains = gains + mode * n;
+      if (m_useGainTable)
+        {
+          for (uint32_t i = 0; i < n; i++)
+            {
+              modeGains[i] = LookupGainDb (phi[i] - ori.phi, theta[i] - ori.theta, mode);
+            }
+          continue;
+        }
+      SetBatchAngles (phi, theta, n, ori);
+      DoGetModeGainsDb (&m_batchPhi[0], &m_batchTheta[0], n, mode, modeGains);
+    }
+}
+
+double
+WifiAntennaModel::GetMaxGainDb (void) const
+{
+  return std::numeric_limits<double>::infinity ();
+}
+
+void
+WifiAntennaModel::SetUseGainTable (bool use)
+{
+  NS_LOG_FUNCTION (this << use);
+  m_useGainTable = use;
+}
+
+bool
+WifiAntennaModel::GetUseGainTable (void) const
+{
+  return m_useGainTable;
+}
+
+void
+WifiAntennaModel::SetGainTableResolution (double degrees)
+{
+  NS_LOG_FUNCTION (this << degrees);
+  m_gainTableResolution = degrees;
+  m_gainTable = 0;
+}
+
+double
+WifiAntennaModel::GetGainTableResolution (void) const
+{
+  return m_gainTableResolution;
+}
+
+void
+WifiAntennaModel::InvalidateGainTable (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_gainTable = 0;
+}
+
+double
+WifiAntennaModel::LookupGainDb (double phi, double theta, int mode) const
+{
+  if (m_gainTable == 0)
+    {
+      BuildGainTable ();
+    }
+  if (m_gainTableInterpolation == GAIN_TABLE_NEAREST)
+    {
+      return m_gainTable->GetNearest (mode, phi, theta);
+    }
+  return m_gainTable->GetInterpolated (mode, phi, theta);
+}
+
+void
+WifiAntennaModel::BuildGainTable (void) const
+{
+  // tables are shared by antennas whose patterns match: in a typical
+  // scenario every node has the same antenna. The options of the table
+  // itself and the attributes SetAntennaMode changes do not tell
+  // patterns apart, the table covers every mode.
+  uint32_t n = 8 * std::max (1, static_cast<int> (std::floor (45.0 / m_gainTableResolution + 0.5)));
+  std::ostringstream signature;
+  signature << n;
+  for (TypeId tid = GetInstanceTypeId (); tid != WifiAntennaModel::GetTypeId (); tid = tid.GetParent ())
+    {
+      signature << ";" << tid.GetName ();
+      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info = tid.GetAttribute (i);
+          if (!(info.flags & TypeId::ATTR_GET) || !info.accessor->HasGetter ()
+              || IsModeAttribute (info.name))
+            {
+              continue;
+            }
+          Ptr<AttributeValue> value = info.checker->Create ();
+          if (GetAttributeFailSafe (info.name, *value))
+            {
+              signature << "," << info.name << "=" << value->SerializeToString (info.checker);
+            }
+        }
+      if (tid == tid.GetParent ())
+        {
+          break;
+        }
+    }
+
+  m_gainTable = WifiAntennaGainTableRegistry::Lookup (signature.str ());
+  if (m_gainTable != 0)
+    {
+      return;
+    }
+  NS_LOG_LOGIC (this << " building a " << n << "x" << n << " gain table for " << signature.str ());
+  int nModes = GetNAntennaModes ();
+  Ptr<WifiAntennaGainTable> table = Create<WifiAntennaGainTable> (nModes, n);
+  for (int mode = 0; mode < nModes; mode++)
+    {
+      for (uint32_t j = 0; j < n; j++)
+        {
+          for (uint32_t i = 0; i < n; i++)
+            {
+              Angles a (table->GetSampleAngle (i), table->GetSampleAngle (j));
+              table->Set (mode, i, j, DoGetModeGainDb (a, mode));
+            }
+        }
+    }
+  table->Compact ();
+  WifiAntennaGainTableRegistry::Add (signature.str (), table);
+  m_gainTable = table;
+}
+
+bool
+WifiAntennaModel::IsModeAttribute (const std::string &name) const
+{
+  return false;
+}
+
 void
 WifiAntennaModel::SetAntennaMode (int mode){
-  m_antennaMode = mode;
+  ChangeAntennaMode (mode);
   return;
 }
 
@@ -100,28 +411,50 @@ WifiAntennaModel::SetAntennaMode (Angles bet){
 
 int
 WifiAntennaModel::GetNextAntennaMode (Angles bet){
-  return m_antennaMode;
+  return m_state->mode;
+}
+
+void
+WifiAntennaModel::SetAntennaMode (const Vector &direction)
+{
+  if (direction.x == 0 && direction.y == 0)
+    {
+      // no azimuth to point to; keep the mode the Angles path picks for phi = 0
+      SetAntennaMode (Angles (0, 0));
+      return;
+    }
+  SetAntennaMode (Angles (direction));
+}
+
+int
+WifiAntennaModel::GetNextAntennaMode (const Vector &direction)
+{
+  if (direction.x == 0 && direction.y == 0)
+    {
+      return GetNextAntennaMode (Angles (0, 0));
+    }
+  return GetNextAntennaMode (Angles (direction));
 }
 
 int
 WifiAntennaModel::GetAntennaMode (){
-  return m_antennaMode;
+  return m_state->mode;
 }
 
-void
-WifiAntennaModel::RegisterListener (WifiAntennaListener *listener)
+Ptr<WifiAntennaState>
+WifiAntennaModel::GetState (void) const
 {
-  NS_LOG_FUNCTION(this << listener);
-  m_listeners.push_back (listener);
+  return m_state;
 }
 
 void
-WifiAntennaModel::NotifyChangeAntennaMode (int mode)
+WifiAntennaModel::ChangeAntennaMode (int mode)
 {
-  for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
+  int old = m_state->mode;
+  m_state->mode = mode;
+  if (mode != old)
     {
-      NS_LOG_DEBUG(this << " " << (*i));
-      (*i)->NotifyChangeAntennaMode (mode);
+      m_modeChangeTrace (old, mode);
     }
 }
 
@@ -25,19 +25,15 @@
 #include <ns3/object.h>
 #include <ns3/angles.h>
 #include <ns3/orientation-model.h>
+#include <ns3/wifi-antenna-gain-table.h>
+#include <ns3/wifi-antenna-state.h>
+#include <ns3/traced-callback.h>
 
 namespace ns3 {
 
 class MobilityModel;
 class MobilityModel;
 
-class WifiAntennaListener
-{
-public:
-  virtual ~WifiAntennaListener ();
-  virtual void NotifyChangeAntennaMode (int mode) = 0;
-};
-
 /** 
  * \ingroup antenna
  * 
@@ -55,9 +51,25 @@ public:
 class WifiAntennaModel : public Object
 {
 public:
+  /**
+   * The number of modes of the default switched-beam antenna: omni
+   * plus four 90 degree sectors. The number of modes of a given
+   * antenna is GetNAntennaModes ().
+   */
   const static int NUMBER_OF_ANTENNA_MODES = 5;
-  int m_antennaMode;
-
+  /**
+   * The largest number of modes any antenna may have (omni plus 16
+   * sectors); per-mode arrays are sized with it.
+   */
+  const static int MAX_ANTENNA_MODES = 17;
+  /**
+   * How the gain table is read between samples.
+   */
+  enum GainTableInterpolation
+  {
+    GAIN_TABLE_NEAREST = 0,
+    GAIN_TABLE_LINEAR = 1
+  };
   WifiAntennaModel ();
   virtual ~WifiAntennaModel ();
 
@@ -75,21 +87,149 @@ public:
    * \return gain in db
    */
   virtual double GetGainDb (Ptr<MobilityModel> src, Ptr<MobilityModel> dest);
+  /**
+   * Same as GetGainDb (src, dest), but evaluates the pattern of the
+   * given antenna mode. The current mode of the antenna is left
+   * untouched and the ModeChange trace is not fired.
+   *
+   * \param src the mobility of the node the antenna is on
+   * \param dest the mobility of the other node
+   * \param mode the antenna mode to evaluate
+   * \return gain in db
+   */
+  double GetGainDb (Ptr<MobilityModel> src, Ptr<MobilityModel> dest, int mode) const;
+  /**
+   * Evaluate the gain towards dest of every antenna mode at once,
+   * without changing the current mode of the antenna.
+   *
+   * \param src the mobility of the node the antenna is on
+   * \param dest the mobility of the other node
+   * \param gains filled with the gain in db of each of the
+   * GetNAntennaModes () antenna modes
+   */
+  void GetGainsDb (Ptr<MobilityModel> src, Ptr<MobilityModel> dest,
+                   double gains[MAX_ANTENNA_MODES]) const;
+  /**
+   * Same as GetGainDb (src, dest), from the direction of the other
+   * node, e.g., one computed once by a WifiPairGeometry.
+   *
+   * \param direction the direction of the other node seen from the
+   * node the antenna is on
+   * \return gain in db
+   */
+  double GetGainDb (const Angles &direction);
+  /**
+   * Same as GetGainsDb (src, dest, gains), from the direction of the
+   * other node.
+   *
+   * \param direction the direction of the other node seen from the
+   * node the antenna is on
+   * \param gains filled with the gain in db of each antenna mode
+   */
+  void GetGainsDb (const Angles &direction, double gains[MAX_ANTENNA_MODES]) const;
+  /**
+   * Same as GetGainDb (direction), towards n directions at once. The
+   * directions are given as an array of azimuths and an array of
+   * inclinations, each in [0, 2*pi] as Angles holds them, so that the
+   * models can evaluate their pattern in loops the compiler vectorizes.
+   *
+   * \param phi the n azimuths
+   * \param theta the n inclinations
+   * \param n the number of directions
+   * \param gains filled with the n gains in db
+   */
+  void GetGainDb (const double *phi, const double *theta, uint32_t n, double *gains);
+  /**
+   * Same as GetGainsDb (direction, gains), towards n directions at once.
+   *
+   * \param phi the n azimuths, in [0, 2*pi]
+   * \param theta the n inclinations, in [0, 2*pi]
+   * \param n the number of directions
+   * \param gains filled with the gain in db of each antenna mode towards
+   * each direction, the gain of mode towards direction i being
+   * gains[mode * n + i]
+   */
+  void GetGainsDb (const double *phi, const double *theta, uint32_t n, double *gains) const;
+  /**
+   * \return the number of antenna modes, at most MAX_ANTENNA_MODES.
+   * The default is 1: an antenna without sectors only has the omni
+   * mode 0, so per-mode work is done once.
+   */
+  virtual uint32_t GetNAntennaModes (void) const;
+  /**
+   * \return an upper bound of the gain (dB) that GetGainDb can return
+   * for any direction and any antenna mode. The default is +infinity,
+   * i.e., no bound is known; models should override this when they can.
+   */
+  virtual double GetMaxGainDb (void) const;
+
+  /**
+   * Serve the per-mode gains from a table of the radiation pattern of
+   * every mode instead of evaluating the pattern on every query. The
+   * table is built on the first query and shared, through the
+   * WifiAntennaGainTableRegistry, by every antenna of the same type
+   * whose pattern attributes have the same values. While it is in use,
+   * GetGainDb (src, dest) returns the gain of the current mode.
+   *
+   * \param use whether to use the gain table
+   */
+  void SetUseGainTable (bool use);
+  bool GetUseGainTable (void) const;
+  /**
+   * \param degrees the angular step of the gain table, rounded so
+   * that 45 degrees is a whole number of steps
+   */
+  void SetGainTableResolution (double degrees);
+  double GetGainTableResolution (void) const;
+  /**
+   * Drop the gain table, so that the next query rebuilds it. Needed
+   * only if the pattern of the antenna changes after the first query.
+   */
+  void InvalidateGainTable (void);
   virtual void SetAntennaMode (int mode);
   virtual void SetAntennaMode (Angles bet);
   virtual int GetNextAntennaMode (Angles bet);
+  /**
+   * Same as SetAntennaMode (Angles) and GetNextAntennaMode (Angles),
+   * but from the displacement vector towards the other node, which
+   * saves the caller from building an Angles. The default converts the
+   * vector to Angles; models with sectors classify it directly.
+   *
+   * \param direction the position of the other node minus the position
+   * of this one; only the x-y components are used
+   */
+  virtual void SetAntennaMode (const Vector &direction);
+  virtual int GetNextAntennaMode (const Vector &direction);
   int GetAntennaMode ();
 
   void SetOrientationModel (Ptr<OrientationModel> orientation);
   Angles GetOrientation ();
   void SetOrientation (const Angles &orientation);
 
-  void RegisterListener (WifiAntennaListener *listener);
-  void NotifyChangeAntennaMode (int mode);
+  /**
+   * \return the mode of this antenna, to be read directly by the
+   * components of the PHY and MAC which depend on it
+   */
+  Ptr<WifiAntennaState> GetState (void) const;
 
 protected:
-  typedef std::vector<WifiAntennaListener *> Listeners;
-  Listeners m_listeners;
+  /**
+   * Record the new mode in the shared state and fire the ModeChange
+   * trace if it differs from the current one.
+   *
+   * \param mode the new antenna mode
+   */
+  void ChangeAntennaMode (int mode);
+
+  Ptr<WifiAntennaState> m_state; //!< Shared with the PHY and MAC
+
+  /**
+   * \param mode an antenna mode
+   * \return the orientation the antenna has when it is in that mode.
+   * The default is the orientation of the orientation model, i.e.,
+   * a model whose orientation does not depend on the mode.
+   */
+  virtual Angles GetModeOrientation (int mode) const;
 private:
   /**
    * this method is expected to be re-implemented by each antenna model 
@@ -102,9 +242,72 @@ private:
    * isotropic radiator. Since a power gain is used, the efficiency of
    * the antenna is expected to be included in the gain value. 
    */
-  virtual double DoGetGainDb (Angles a) = 0;
+  virtual double DoGetGainDb (Angles a) const = 0;
+  /**
+   * Same as DoGetGainDb (a), but for the given antenna mode rather
+   * than the current one. The default is suitable for models whose
+   * pattern does not depend on the mode.
+   *
+   * \param a the spherical angles, relative to GetModeOrientation (mode)
+   * \param mode the antenna mode to evaluate
+   * \return the power gain in dBi
+   */
+  virtual double DoGetModeGainDb (Angles a, int mode) const;
+  /**
+   * \param name the name of an attribute of this model
+   * \return whether SetAntennaMode changes the attribute, which then
+   * does not tell gain tables apart. The default is false.
+   */
+  virtual bool IsModeAttribute (const std::string &name) const;
+  /**
+   * Same as DoGetGainDb, for n directions at once. The default calls
+   * DoGetGainDb for each of them.
+   *
+   * \param phi the n azimuths relative to the orientation, in [0, 2*pi]
+   * \param theta the n inclinations relative to the orientation, in [0, 2*pi]
+   * \param n the number of directions
+   * \param gains filled with the n gains in dBi
+   */
+  virtual void DoGetGainsDb (const double *phi, const double *theta, uint32_t n, double *gains) const;
+  /**
+   * Same as DoGetModeGainDb, for n directions at once. The default
+   * calls DoGetModeGainDb for each of them.
+   *
+   * \param phi the n azimuths relative to GetModeOrientation (mode)
+   * \param theta the n inclinations relative to GetModeOrientation (mode)
+   * \param n the number of directions
+   * \param mode the antenna mode to evaluate
+   * \param gains filled with the n gains in dBi
+   */
+  virtual void DoGetModeGainsDb (const double *phi, const double *theta, uint32_t n, int mode,
+                                 double *gains) const;
+  /**
+   * Fill m_batchPhi and m_batchTheta with the n directions relative to
+   * the orientation ori, normalized like NormalizeOverTwoPI does.
+   */
+  void SetBatchAngles (const double *phi, const double *theta, uint32_t n, const Angles &ori) const;
+
+  /**
+   * \param phi the azimuth relative to the mode orientation, any value
+   * \param theta the inclination relative to the mode orientation, any value
+   * \param mode the antenna mode
+   * \return the gain (dB) read from the gain table
+   */
+  double LookupGainDb (double phi, double theta, int mode) const;
+  /**
+   * Find the gain table matching the attributes of this antenna, or
+   * sample the pattern of every mode to build it.
+   */
+  void BuildGainTable (void) const;
 
   Ptr<OrientationModel> m_orientation;
+  bool m_useGainTable;
+  double m_gainTableResolution; //!< degrees
+  enum GainTableInterpolation m_gainTableInterpolation;
+  mutable Ptr<WifiAntennaGainTable> m_gainTable;
+  mutable std::vector<double> m_batchPhi;   //!< Scratch relative azimuths
+  mutable std::vector<double> m_batchTheta; //!< Scratch relative inclinations
+  TracedCallback<int, int> m_modeChangeTrace; //!< Fired with the old and new mode
 };
 
 
@@ -0,0 +1,48 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef WIFI_ANTENNA_STATE_H
+#define WIFI_ANTENNA_STATE_H
+
+#include <ns3/simple-ref-count.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup antenna
+ * \brief the mode of an antenna, shared by everything that needs it
+ *
+ * The antenna model owns the state and updates it on every mode
+ * change. The MAC, the channel access manager and the PHY read it
+ * through the same pointer, so they can never disagree on the mode
+ * and nothing has to be notified when it changes.
+ */
+struct WifiAntennaState : public SimpleRefCount<WifiAntennaState>
+{
+  WifiAntennaState ()
+    : mode (0),
+      nextMode (0),
+      nModes (1)
+  {
+  }
+
+  int mode;     //!< Current antenna mode
+  int nextMode; //!< Mode the antenna will be in for the next transmission
+  int nModes;   //!< Number of modes of the antenna
+};
+
+} // namespace ns3
+
+#endif /* WIFI_ANTENNA_STATE_H */
@@ -21,6 +21,7 @@
 #include <ns3/log.h>
 #include <ns3/double.h>
 #include <limits>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 
@@ -72,7 +73,7 @@ WifiConstantGainAntennaModel::GetTypeId ()
 }
 
 double
-WifiConstantGainAntennaModel::DoGetGainDb (Angles a)
+WifiConstantGainAntennaModel::DoGetGainDb (Angles a) const
 {
   NS_LOG_FUNCTION (this << a);
   if((GetAzimuthBeamwidth()/2) > 0 && (GetAzimuthBeamwidth()/2) < M_PI/2)
@@ -89,6 +90,40 @@ WifiConstantGainAntennaModel::DoGetGainDb (Angles a)
   return m_innerGain;
 }
 
+void
+WifiConstantGainAntennaModel::DoGetGainsDb (const double *phi, const double *theta, uint32_t n,
+                                            double *gains) const
+{
+  double innerGain = m_innerGain;
+  double outerGain = m_outerGain;
+  double halfAzimuth = GetAzimuthBeamwidth () / 2;
+  double maxTheta = (GetElevationBeamwidth () / 2) + .000001;
+  if (halfAzimuth > 0 && halfAzimuth < M_PI/2)
+    {
+      double minPhi = halfAzimuth + .000001;
+      double maxPhi = ((M_PI*2) - halfAzimuth) - .000001;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          bool outside = ((phi[i] > minPhi) & (phi[i] <= M_PI))
+            | ((phi[i] < maxPhi) & (phi[i] >= M_PI))
+            | (theta[i] > maxTheta);
+          gains[i] = outside ? outerGain : innerGain;
+        }
+      return;
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      gains[i] = theta[i] > maxTheta ? outerGain : innerGain;
+    }
+}
+
+void
+WifiConstantGainAntennaModel::DoGetModeGainsDb (const double *phi, const double *theta, uint32_t n,
+                                                int mode, double *gains) const
+{
+  DoGetGainsDb (phi, theta, n, gains);
+}
+
 void 
 WifiConstantGainAntennaModel::SetGainInsidePattern (double gain)
 {
@@ -141,6 +176,12 @@ WifiConstantGainAntennaModel::GetElevationBeamwidth (void) const
   return m_elvBW;
 }
 
+double
+WifiConstantGainAntennaModel::GetMaxGainDb (void) const
+{
+  return std::max (m_innerGain, m_outerGain);
+}
+
 }
 
 
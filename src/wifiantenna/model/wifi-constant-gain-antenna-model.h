@@ -57,6 +57,9 @@ public:
   void SetElevationBeamwidth (double bw);
   double GetElevationBeamwidth (void) const;
 
+  // inherited from WifiAntennaModel
+  virtual double GetMaxGainDb (void) const;
+
 private:
   double m_innerGain;
   double m_outerGain;
@@ -64,7 +67,10 @@ private:
   double m_elvBW;
  
   //Angles m_orientation;
-  virtual double DoGetGainDb (Angles a);
+  virtual double DoGetGainDb (Angles a) const;
+  virtual void DoGetGainsDb (const double *phi, const double *theta, uint32_t n, double *gains) const;
+  virtual void DoGetModeGainsDb (const double *phi, const double *theta, uint32_t n, int mode,
+                                 double *gains) const;
 };
 
 }
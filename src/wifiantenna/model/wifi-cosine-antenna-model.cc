@@ -70,8 +70,15 @@ WifiCosineAntennaModel::GetBeamwidth () const
   return RadiansToDegrees (m_beamwidthRadians);
 }
 
+double
+WifiCosineAntennaModel::GetMaxGainDb (void) const
+{
+  // the element factor never exceeds one
+  return m_maxGain;
+}
+
 double 
-WifiCosineAntennaModel::DoGetGainDb (Angles a)
+WifiCosineAntennaModel::DoGetGainDb (Angles a) const
 {
   NS_LOG_FUNCTION (this << a);
   // azimuth angle w.r.t. the reference system of the antenna
@@ -103,4 +110,26 @@ WifiCosineAntennaModel::DoGetGainDb (Angles a)
   return gainDb + m_maxGain;
 }
 
+void
+WifiCosineAntennaModel::DoGetGainsDb (const double *phi, const double *theta, uint32_t n,
+                                      double *gains) const
+{
+  // copies, so that the compiler knows gains does not alias them
+  double exponent = m_exponent;
+  double maxGain = m_maxGain;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // phi is in [0, 2 pi]: one turn at most brings it in (-pi, pi]
+      double p = phi[i] > M_PI ? phi[i] - (M_PI+M_PI) : phi[i];
+      gains[i] = 20 * std::log10 (std::pow (std::cos (p / 2.0), exponent)) + maxGain;
+    }
+}
+
+void
+WifiCosineAntennaModel::DoGetModeGainsDb (const double *phi, const double *theta, uint32_t n,
+                                          int mode, double *gains) const
+{
+  DoGetGainsDb (phi, theta, n, gains);
+}
+
 }
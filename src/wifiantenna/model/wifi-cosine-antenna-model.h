@@ -51,6 +51,9 @@ public:
   void SetBeamwidth (double beamwidthDegrees);
   double GetBeamwidth () const;
 
+  // inherited from WifiAntennaModel
+  virtual double GetMaxGainDb (void) const;
+
 private:
 
   /**
@@ -64,7 +67,10 @@ private:
   double m_maxGain;
   
   // inherited from AntennaModel
-  virtual double DoGetGainDb (Angles a);
+  virtual double DoGetGainDb (Angles a) const;
+  virtual void DoGetGainsDb (const double *phi, const double *theta, uint32_t n, double *gains) const;
+  virtual void DoGetModeGainsDb (const double *phi, const double *theta, uint32_t n, int mode,
+                                 double *gains) const;
 };
 
 
@@ -48,8 +48,14 @@ WifiIsotropicAntennaModel::WifiIsotropicAntennaModel ()
   NS_LOG_FUNCTION (this);
 }
 
+double
+WifiIsotropicAntennaModel::GetMaxGainDb (void) const
+{
+  return 0.0;
+}
+
 double 
-WifiIsotropicAntennaModel::DoGetGainDb (Angles a)
+WifiIsotropicAntennaModel::DoGetGainDb (Angles a) const
 {
   NS_LOG_FUNCTION (this << a);
   return 0.0;
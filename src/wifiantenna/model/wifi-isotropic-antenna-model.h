@@ -40,10 +40,13 @@ public:
   // inherited from Object
   static TypeId GetTypeId ();
 
+  // inherited from WifiAntennaModel
+  virtual double GetMaxGainDb (void) const;
+
 private:
 
   // inherited from WifiAntennaModel
-  virtual double DoGetGainDb (Angles a);
+  virtual double DoGetGainDb (Angles a) const;
 
 };
 
@@ -0,0 +1,75 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "wifi-pair-geometry.h"
+#include <cmath>
+
+namespace ns3 {
+
+WifiPairGeometry::WifiPairGeometry (const Vector &src, const Vector &dest)
+  : m_src (src),
+    m_dest (dest),
+    m_displacement (dest.x - src.x, dest.y - src.y, dest.z - src.z)
+{
+  m_distance = std::sqrt (m_displacement.x * m_displacement.x
+                          + m_displacement.y * m_displacement.y
+                          + m_displacement.z * m_displacement.z);
+  // same as Angles (dest, src), without evaluating the distance again
+  m_direction.phi = NormalizeOverTwoPI (std::atan2 (m_displacement.y, m_displacement.x));
+  m_direction.theta = NormalizeOverTwoPI (std::acos (m_displacement.z / m_distance));
+  // the opposite direction: half a turn in azimuth, mirrored
+  // inclination. The azimuth is in [0, 2 pi), wrap it like atan2 would
+  double phi = m_direction.phi + M_PI;
+  m_reverseDirection.phi = phi >= 2 * M_PI ? phi - 2 * M_PI : phi;
+  m_reverseDirection.theta = NormalizeOverTwoPI (M_PI - m_direction.theta);
+}
+
+const Vector &
+WifiPairGeometry::GetSrcPosition (void) const
+{
+  return m_src;
+}
+
+const Vector &
+WifiPairGeometry::GetDestPosition (void) const
+{
+  return m_dest;
+}
+
+const Vector &
+WifiPairGeometry::GetDisplacement (void) const
+{
+  return m_displacement;
+}
+
+double
+WifiPairGeometry::GetDistance (void) const
+{
+  return m_distance;
+}
+
+const Angles &
+WifiPairGeometry::GetDirection (void) const
+{
+  return m_direction;
+}
+
+const Angles &
+WifiPairGeometry::GetReverseDirection (void) const
+{
+  return m_reverseDirection;
+}
+
+} // namespace ns3
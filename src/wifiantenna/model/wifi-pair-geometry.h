@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef WIFI_PAIR_GEOMETRY_H
+#define WIFI_PAIR_GEOMETRY_H
+
+#include <ns3/vector.h>
+#include <ns3/angles.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup antenna
+ *
+ * \brief geometry of a transmitter and receiver pair
+ *
+ * Everything the antenna, loss and delay models derive from the two
+ * positions, computed once: the displacement, the distance, and the
+ * direction of each node as seen from the other. The reverse
+ * direction is derived from the forward one rather than evaluated
+ * again, so it may differ from Angles (src, dest) in the last bit.
+ */
+class WifiPairGeometry
+{
+public:
+  /**
+   * \param src the position of the transmitter
+   * \param dest the position of the receiver
+   */
+  WifiPairGeometry (const Vector &src, const Vector &dest);
+
+  /**
+   * \return the position of the transmitter
+   */
+  const Vector &GetSrcPosition (void) const;
+  /**
+   * \return the position of the receiver
+   */
+  const Vector &GetDestPosition (void) const;
+  /**
+   * \return the position of the receiver minus that of the transmitter
+   */
+  const Vector &GetDisplacement (void) const;
+  /**
+   * \return the distance (m) between the two nodes
+   */
+  double GetDistance (void) const;
+  /**
+   * \return the direction of the receiver seen from the transmitter,
+   * i.e., Angles (dest, src)
+   */
+  const Angles &GetDirection (void) const;
+  /**
+   * \return the direction of the transmitter seen from the receiver,
+   * i.e., Angles (src, dest)
+   */
+  const Angles &GetReverseDirection (void) const;
+
+private:
+  Vector m_src;
+  Vector m_dest;
+  Vector m_displacement;
+  double m_distance;
+  Angles m_direction;
+  Angles m_reverseDirection;
+};
+
+} // namespace ns3
+
+#endif /* WIFI_PAIR_GEOMETRY_H */
@@ -23,6 +23,7 @@
 #include <ns3/double.h>
 #include <ns3/angles.h>
 #include <cmath>
+#include <algorithm>
 
 #include "wifi-antenna-model.h"
 #include "wifi-parabolic-antenna-model.h"
@@ -69,8 +70,15 @@ WifiParabolicAntennaModel::GetBeamwidth () const
   return RadiansToDegrees (m_beamwidthRadians);
 }
 
+double
+WifiParabolicAntennaModel::GetMaxGainDb (void) const
+{
+  // the gain peaks at the boresight, unless the attenuation cap is negative
+  return std::max (0.0, -m_maxAttenuation);
+}
+
 double 
-WifiParabolicAntennaModel::DoGetGainDb (Angles a)
+WifiParabolicAntennaModel::DoGetGainDb (Angles a) const
 {
   NS_LOG_FUNCTION (this << a);
   // azimuth angle w.r.t. the reference system of the antenna
@@ -94,6 +102,28 @@ WifiParabolicAntennaModel::DoGetGainDb (Angles a)
   return gainDb;
 }
 
+void
+WifiParabolicAntennaModel::DoGetGainsDb (const double *phi, const double *theta, uint32_t n,
+                                         double *gains) const
+{
+  // copies, so that the compiler knows gains does not alias them
+  double beamwidth = m_beamwidthRadians;
+  double maxAttenuation = m_maxAttenuation;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // phi is in [0, 2 pi]: one turn at most brings it in (-pi, pi]
+      double p = phi[i] > M_PI ? phi[i] - (M_PI+M_PI) : phi[i];
+      gains[i] = -std::min (12 * pow (p / beamwidth, 2), maxAttenuation);
+    }
+}
+
+void
+WifiParabolicAntennaModel::DoGetModeGainsDb (const double *phi, const double *theta, uint32_t n,
+                                             int mode, double *gains) const
+{
+  DoGetGainsDb (phi, theta, n, gains);
+}
+
 
 }
 
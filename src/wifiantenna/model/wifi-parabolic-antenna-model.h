@@ -53,6 +53,9 @@ public:
   void SetBeamwidth (double beamwidthDegrees);
   double GetBeamwidth () const;
 
+  // inherited from WifiAntennaModel
+  virtual double GetMaxGainDb (void) const;
+
 private:
 
   double m_beamwidthRadians;
@@ -62,7 +65,10 @@ private:
   double m_maxAttenuation;
 
   // inherited from WifiAntennaModel
-  virtual double DoGetGainDb (Angles a);
+  virtual double DoGetGainDb (Angles a) const;
+  virtual void DoGetGainsDb (const double *phi, const double *theta, uint32_t n, double *gains) const;
+  virtual void DoGetModeGainsDb (const double *phi, const double *theta, uint32_t n, int mode,
+                                 double *gains) const;
 };
 
 
@@ -21,7 +21,10 @@
 
 #include <ns3/log.h>
 #include <ns3/double.h>
+#include <ns3/uinteger.h>
 #include <limits>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 
@@ -75,25 +78,74 @@ WifiSwitchedBeamAntennaModel::GetTypeId ()
                         &WifiSwitchedBeamAntennaModel::SetElevationBeamwidth, 
                         &WifiSwitchedBeamAntennaModel::GetElevationBeamwidth),
                    MakeDoubleChecker<double> (0, M_PI)) 
+    .AddAttribute ("Sectors",
+                   "The number of directional sectors, which evenly divide the azimuth",
+                   UintegerValue (NUMBER_OF_ANTENNA_MODES - 1),
+                   MakeUintegerAccessor (
+                        &WifiSwitchedBeamAntennaModel::SetNSectors,
+                        &WifiSwitchedBeamAntennaModel::GetNSectors),
+                   MakeUintegerChecker<uint32_t> (1, MAX_ANTENNA_MODES - 1))
     ;
   return tid;
 }
 
+WifiSwitchedBeamAntennaModel::WifiSwitchedBeamAntennaModel ()
+  : m_nSectors (0)
+{
+  SetNSectors (NUMBER_OF_ANTENNA_MODES - 1);
+}
+
 double
-WifiSwitchedBeamAntennaModel::DoGetGainDb (Angles a)
+WifiSwitchedBeamAntennaModel::DoGetGainDb (Angles a) const
 {
   //  double phi   = GetOrientation().phi;
   //  double theta = GetOrientation().theta;
   NS_LOG_FUNCTION (this << a);
-  if(m_antennaMode == OMNI) {
+  if(m_state->mode == OMNI) {
     return m_omniGain;
   }
-  if((GetAzimuthBeamwidth()/2) > 0 && (GetAzimuthBeamwidth()/2) < M_PI/2)
+  return GetBeamGainDb (a, GetAzimuthBeamwidth ());
+}
+
+double
+WifiSwitchedBeamAntennaModel::DoGetModeGainDb (Angles a, int mode) const
+{
+  NS_LOG_FUNCTION (this << a << mode);
+  if(mode == OMNI) {
+    return m_omniGain;
+  }
+  // the beamwidth SetAntennaMode gives to every directional mode
+  return GetBeamGainDb (a, 2 * M_PI / m_nSectors);
+}
+
+bool
+WifiSwitchedBeamAntennaModel::IsModeAttribute (const std::string &name) const
+{
+  // SetAntennaMode sets the beamwidth of the mode it switches to
+  return name == "AzimuthBeamwidth";
+}
+
+Angles
+WifiSwitchedBeamAntennaModel::GetModeOrientation (int mode) const
+{
+  if(mode == OMNI) {
+    return Angles (0, 0);
+  }
+  // each sector is centered in its share of the azimuth; with four
+  // sectors DIRECTIONAL0 is centered on 45 degrees
+  return Angles ((2 * mode - 1) * M_PI / m_nSectors, (double)0);
+}
+
+double
+WifiSwitchedBeamAntennaModel::GetBeamGainDb (Angles a, double aziBW) const
+{
+  // a beam of 2 pi or more covers every azimuth
+  if((aziBW/2) > 0 && (aziBW/2) < M_PI)
   {
-    if(a.phi > (GetAzimuthBeamwidth()/2) && a.phi <= M_PI){
+    if(a.phi > (aziBW/2) && a.phi <= M_PI){
       return m_outerGain;
     }
-    if(a.phi < ((M_PI*2)-(GetAzimuthBeamwidth()/2)) && a.phi >= M_PI) {
+    if(a.phi < ((M_PI*2)-(aziBW/2)) && a.phi >= M_PI) {
       return m_outerGain;
     }
   }
@@ -105,6 +157,54 @@ WifiSwitchedBeamAntennaModel::DoGetGainDb (Angles a)
   return m_innerGain;
 }
 
+void
+WifiSwitchedBeamAntennaModel::GetBeamGainsDb (const double *phi, const double *theta, uint32_t n,
+                                              double aziBW, double *gains) const
+{
+  double innerGain = m_innerGain;
+  double outerGain = m_outerGain;
+  double maxTheta = GetElevationBeamwidth () / 2;
+  if ((aziBW/2) > 0 && (aziBW/2) < M_PI)
+    {
+      double minPhi = aziBW/2;
+      double maxPhi = (M_PI*2) - (aziBW/2);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          bool outside = ((phi[i] > minPhi) & (phi[i] <= M_PI))
+            | ((phi[i] < maxPhi) & (phi[i] >= M_PI))
+            | (theta[i] > maxTheta);
+          gains[i] = outside ? outerGain : innerGain;
+        }
+      return;
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      gains[i] = theta[i] > maxTheta ? outerGain : innerGain;
+    }
+}
+
+void
+WifiSwitchedBeamAntennaModel::DoGetGainsDb (const double *phi, const double *theta, uint32_t n,
+                                            double *gains) const
+{
+  if(m_state->mode == OMNI) {
+    std::fill (gains, gains + n, m_omniGain);
+    return;
+  }
+  GetBeamGainsDb (phi, theta, n, GetAzimuthBeamwidth (), gains);
+}
+
+void
+WifiSwitchedBeamAntennaModel::DoGetModeGainsDb (const double *phi, const double *theta, uint32_t n,
+                                                int mode, double *gains) const
+{
+  if(mode == OMNI) {
+    std::fill (gains, gains + n, m_omniGain);
+    return;
+  }
+  GetBeamGainsDb (phi, theta, n, 2 * M_PI / m_nSectors, gains);
+}
+
 void 
 WifiSwitchedBeamAntennaModel::SetGainInsidePattern (double gain)
 {
@@ -171,81 +271,139 @@ WifiSwitchedBeamAntennaModel::GetElevationBeamwidth (void) const
   return m_elvBW;
 }
 
+void
+WifiSwitchedBeamAntennaModel::SetNSectors (uint32_t nSectors)
+{
+  NS_LOG_FUNCTION (this << nSectors);
+  NS_ASSERT (nSectors >= 1 && nSectors < static_cast<uint32_t> (MAX_ANTENNA_MODES));
+  m_state->nModes = 1 + nSectors;
+  if (nSectors == m_nSectors)
+    {
+      return;
+    }
+  m_nSectors = nSectors;
+  SetSectorBoundaries (nSectors);
+  InvalidateGainTable ();
+}
+
+uint32_t
+WifiSwitchedBeamAntennaModel::GetNSectors (void) const
+{
+  return m_nSectors;
+}
+
+uint32_t
+WifiSwitchedBeamAntennaModel::GetNAntennaModes (void) const
+{
+  return 1 + m_nSectors;
+}
+
+double
+WifiSwitchedBeamAntennaModel::GetMaxGainDb (void) const
+{
+  return std::max (m_omniGain, std::max (m_innerGain, m_outerGain));
+}
+
 int
 WifiSwitchedBeamAntennaModel::GetNextAntennaMode (Angles bet){
-
-  double ang0   = 0;
-  double ang90  = M_PI / 2;
-  double ang180 = M_PI;
-  double ang270 = 3 * M_PI / 2;
-
-  if(bet.phi >= ang0 && bet.phi < ang90){
-    return DIRECTIONAL0;
-  }else if(bet.phi >= ang90 && bet.phi < ang180){
-    return DIRECTIONAL90;
-  }else if(bet.phi >= ang180 && bet.phi < ang270){
-    return DIRECTIONAL180;
-  }else{
-    return DIRECTIONAL270;
-  }
+  uint32_t sector = static_cast<uint32_t> (bet.phi / (2 * M_PI / m_nSectors));
+  // guard against rounding of an azimuth just below 2 pi
+  return DIRECTIONAL0 + std::min (sector, m_nSectors - 1);
 }
 
 void
 WifiSwitchedBeamAntennaModel::SetAntennaMode (int mode)
 {
-  m_antennaMode = mode;
-
-  Angles ang0(0, 0);
-  Angles ang45((double)M_PI / 4, (double)0);
-  Angles ang135((double)3 * M_PI / 4, (double)0);
-  Angles ang225((double)5 * M_PI / 4, (double)0);
-  Angles ang315((double)7 * M_PI / 4, (double)0);
+  NS_ASSERT (mode >= 0 && mode <= static_cast<int> (m_nSectors));
+  ChangeAntennaMode (mode);
 
-  switch(mode){
-  case OMNI:
+  if(mode == OMNI){
     SetAzimuthBeamwidth (0);
-    SetOrientation (ang0);
-    break;
-  case DIRECTIONAL0:
-    SetAzimuthBeamwidth (M_PI / 2);
-    SetOrientation (ang45);
-    break;
-  case DIRECTIONAL90:
-    SetAzimuthBeamwidth (M_PI / 2);
-    SetOrientation (ang135);
-    break;
-  case DIRECTIONAL180:
-    SetAzimuthBeamwidth (M_PI / 2);
-    SetOrientation (ang225);
-    break;
-  case DIRECTIONAL270:
-    SetAzimuthBeamwidth (M_PI / 2);
-    SetOrientation (ang315);
-    break;
+  }else{
+    SetAzimuthBeamwidth (2 * M_PI / m_nSectors);
   }
+  SetOrientation (GetModeOrientation (mode));
+}
+void
+WifiSwitchedBeamAntennaModel::SetAntennaMode (Angles bet)
+{
+  SetAntennaMode (GetNextAntennaMode (bet));
+}
 
-  for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
+int
+WifiSwitchedBeamAntennaModel::GetNextAntennaMode (const Vector &direction)
+{
+  if (direction.x == 0 && direction.y == 0)
     {
-      (*i)->NotifyChangeAntennaMode (mode);
+      return DIRECTIONAL0;
     }
+  return DIRECTIONAL0 + GetSectorIndex (direction);
 }
+
 void
-WifiSwitchedBeamAntennaModel::SetAntennaMode (Angles bet)
+WifiSwitchedBeamAntennaModel::SetAntennaMode (const Vector &direction)
 {
-  double ang0   = 0;
-  double ang90  = M_PI / 2;
-  double ang180 = M_PI;
-  double ang270 = 3 * M_PI / 2;
-
-  if(bet.phi >= ang0 && bet.phi < ang90){
-    SetAntennaMode (DIRECTIONAL0);
-  }else if(bet.phi >= ang90 && bet.phi < ang180){
-    SetAntennaMode (DIRECTIONAL90);
-  }else if(bet.phi >= ang180 && bet.phi < ang270){
-    SetAntennaMode (DIRECTIONAL180);
-  }else{
-    SetAntennaMode (DIRECTIONAL270);
-  }
+  SetAntennaMode (GetNextAntennaMode (direction));
+}
+
+void
+WifiSwitchedBeamAntennaModel::SetSectorBoundaries (uint32_t nSectors)
+{
+  NS_LOG_FUNCTION (this << nSectors);
+  NS_ASSERT (nSectors > 0);
+  m_sectorBoundaries.clear ();
+  for (uint32_t k = 0; k < nSectors; k++)
+    {
+      double a = 2 * M_PI * k / nSectors;
+      double x = std::cos (a);
+      double y = std::sin (a);
+      // snap the axis-aligned boundaries, so that a direction lying
+      // exactly on an axis is classified like the Angles path does
+      if (std::fabs (x) < 1e-12)
+        {
+          x = 0;
+        }
+      if (std::fabs (y) < 1e-12)
+        {
+          y = 0;
+        }
+      m_sectorBoundaries.push_back (Vector (x, y, 0));
+    }
+}
+
+// 0 for the azimuths in [0, pi), 1 for those in [pi, 2 pi)
+static inline int
+GetHalfPlane (double x, double y)
+{
+  return (y > 0 || (y == 0 && x > 0)) ? 0 : 1;
+}
+
+uint32_t
+WifiSwitchedBeamAntennaModel::GetSectorIndex (const Vector &direction) const
+{
+  // the boundaries are sorted by azimuth, and boundary k is at or
+  // before direction iff it lies in an earlier half-plane, or in the
+  // same half-plane and direction is not clockwise of it. Find the
+  // last such boundary by bisection; boundary 0 always qualifies.
+  int half = GetHalfPlane (direction.x, direction.y);
+  uint32_t lo = 0;
+  uint32_t hi = m_sectorBoundaries.size ();
+  while (hi - lo > 1)
+    {
+      uint32_t mid = (lo + hi) / 2;
+      const Vector &b = m_sectorBoundaries[mid];
+      int bHalf = GetHalfPlane (b.x, b.y);
+      if (bHalf < half
+          || (bHalf == half && b.x * direction.y - b.y * direction.x >= 0))
+        {
+          lo = mid;
+        }
+      else
+        {
+          hi = mid;
+        }
+    }
+  return lo;
 }
 
 }
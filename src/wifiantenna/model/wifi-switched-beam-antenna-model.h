@@ -23,11 +23,20 @@
 #define WIFI_SWITCHED_BEAM_ANTENNA_MODEL_H
 
 #include <ns3/object.h>
+#include <ns3/vector.h>
 #include <ns3/wifi-antenna-model.h>
+#include <vector>
 
 namespace ns3 {
 
 
+/**
+ * \brief an antenna with an omni mode and N equal directional sectors
+ *
+ * Mode 0 is omni, mode k (1 <= k <= N) covers the azimuths
+ * [k - 1, k) * 2 pi / N. The enum names the modes of the default
+ * four-sector antenna.
+ */
 class WifiSwitchedBeamAntennaModel : public WifiAntennaModel
 {
 public:
@@ -41,6 +50,8 @@ public:
   // inherited from Object
   static TypeId GetTypeId ();
 
+  WifiSwitchedBeamAntennaModel ();
+
   // sets the antenna gain in Db
   void SetGainInsidePattern (double gain);
   double GetGainInsidePattern (void) const;
@@ -59,19 +70,74 @@ public:
   void SetElevationBeamwidth (double bw);
   double GetElevationBeamwidth (void) const;
 
+  /**
+   * Set the number of directional sectors. This must be done before
+   * the antenna is attached to a PHY, since the MAC and PHY size
+   * their per-mode state from it.
+   *
+   * \param nSectors the number of sectors, between 1 and
+   * MAX_ANTENNA_MODES - 1
+   */
+  void SetNSectors (uint32_t nSectors);
+  uint32_t GetNSectors (void) const;
+
+  // inherited from WifiAntennaModel
+  virtual double GetMaxGainDb (void) const;
+  virtual uint32_t GetNAntennaModes (void) const;
+
   int GetNextAntennaMode (Angles bet);
   void SetAntennaMode (int mode);
   void SetAntennaMode (Angles bet);
+  /**
+   * Pick the sector containing direction with sign and cross product
+   * tests against the sector boundaries, without any trigonometry.
+   * A direction with no x-y component falls in the first sector.
+   */
+  int GetNextAntennaMode (const Vector &direction);
+  void SetAntennaMode (const Vector &direction);
 
 private:
+  /**
+   * Precompute the unit vectors of the N sector boundaries.
+   *
+   * \param nSectors the number of directional sectors
+   */
+  void SetSectorBoundaries (uint32_t nSectors);
+  /**
+   * \param direction a vector with a non-zero x-y component
+   * \return the index of the sector containing direction
+   */
+  uint32_t GetSectorIndex (const Vector &direction) const;
+
+  // boundary k is the unit vector at azimuth k * 2 pi / N, z unused
+  std::vector<Vector> m_sectorBoundaries;
+
   double m_innerGain;
   double m_outerGain;
   double m_omniGain;
   double m_aziBW;
   double m_elvBW;
+  uint32_t m_nSectors;
  
   //Angles m_orientation;
-  virtual double DoGetGainDb (Angles a);
+  virtual double DoGetGainDb (Angles a) const;
+  virtual double DoGetModeGainDb (Angles a, int mode) const;
+  virtual void DoGetGainsDb (const double *phi, const double *theta, uint32_t n, double *gains) const;
+  virtual void DoGetModeGainsDb (const double *phi, const double *theta, uint32_t n, int mode,
+                                 double *gains) const;
+  virtual Angles GetModeOrientation (int mode) const;
+  virtual bool IsModeAttribute (const std::string &name) const;
+  /**
+   * \param a the spherical angles relative to the beam center
+   * \param aziBW the azimuth beamwidth of the beam (radians)
+   * \return the inside or outside pattern gain
+   */
+  double GetBeamGainDb (Angles a, double aziBW) const;
+  /**
+   * Same as GetBeamGainDb, for n directions at once.
+   */
+  void GetBeamGainsDb (const double *phi, const double *theta, uint32_t n, double aziBW,
+                       double *gains) const;
 };
 
 }
@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/object-factory.h>
+#include <ns3/boolean.h>
+#include <ns3/uinteger.h>
+#include <ns3/wifi-antenna-model.h>
+#include <ns3/wifi-pair-geometry.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "wifi-antenna-test-fixture.h"
+
+
+NS_LOG_COMPONENT_DEFINE ("TestWifiAntennaBatchGain");
+
+using namespace ns3;
+
+/**
+ * Check that the gains computed for a batch of directions are exactly
+ * those computed one direction at a time, in every antenna mode.
+ */
+class WifiAntennaBatchGainTestCase : public TestCase
+{
+public:
+  WifiAntennaBatchGainTestCase (std::string type, uint32_t sectors, bool useGainTable);
+
+private:
+  virtual void DoRun (void);
+
+  std::string m_type;
+  uint32_t m_sectors;
+  bool m_useGainTable;
+};
+
+static std::string
+BuildNameString (std::string type, uint32_t sectors, bool useGainTable)
+{
+  std::ostringstream oss;
+  oss << type;
+  if (sectors > 0)
+    {
+      oss << " sectors=" << sectors;
+    }
+  oss << " table=" << useGainTable;
+  return oss.str ();
+}
+
+WifiAntennaBatchGainTestCase::WifiAntennaBatchGainTestCase (std::string type, uint32_t sectors,
+                                                            bool useGainTable)
+  : TestCase (BuildNameString (type, sectors, useGainTable)),
+    m_type (type),
+    m_sectors (sectors),
+    m_useGainTable (useGainTable)
+{
+}
+
+void
+WifiAntennaBatchGainTestCase::DoRun ()
+{
+  ObjectFactory factory;
+  factory.SetTypeId (m_type);
+  if (m_sectors > 0)
+    {
+      factory.Set ("Sectors", UintegerValue (m_sectors));
+    }
+  factory.Set ("UseGainTable", BooleanValue (m_useGainTable));
+  Ptr<WifiAntennaModel> antenna = CreateWifiTestAntenna (factory);
+
+  std::vector<WifiTestReceiver> receivers = GetWifiTestReceivers ();
+  std::vector<Angles> directions;
+  std::vector<double> phi;
+  std::vector<double> theta;
+  for (uint32_t i = 0; i < receivers.size (); i++)
+    {
+      WifiPairGeometry geometry (GetWifiTestSource (), receivers[i].position);
+      directions.push_back (geometry.GetDirection ());
+      phi.push_back (geometry.GetDirection ().phi);
+      theta.push_back (geometry.GetDirection ().theta);
+    }
+  uint32_t n = directions.size ();
+  int nModes = antenna->GetNAntennaModes ();
+
+  std::vector<double> gains (n);
+  for (int mode = 0; mode < nModes; mode++)
+    {
+      antenna->SetAntennaMode (mode);
+      antenna->GetGainDb (&phi[0], &theta[0], n, &gains[0]);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (gains[i], antenna->GetGainDb (directions[i]),
+                                 "wrong gain of receiver " << i << " in mode " << mode);
+        }
+    }
+
+  std::vector<double> all (n * nModes);
+  antenna->GetGainsDb (&phi[0], &theta[0], n, &all[0]);
+  double expected[WifiAntennaModel::MAX_ANTENNA_MODES];
+  for (uint32_t i = 0; i < n; i++)
+    {
+      antenna->GetGainsDb (directions[i], expected);
+      for (int mode = 0; mode < nModes; mode++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (all[mode * n + i], expected[mode],
+                                 "wrong gain of receiver " << i << " for mode " << mode);
+        }
+    }
+}
+
+
+class WifiAntennaBatchGainTestSuite : public TestSuite
+{
+public:
+  WifiAntennaBatchGainTestSuite ();
+};
+
+WifiAntennaBatchGainTestSuite::WifiAntennaBatchGainTestSuite ()
+  : TestSuite ("wifi-antenna-batch-gain", UNIT)
+{
+  for (uint32_t table = 0; table < 2; table++)
+    {
+      AddTestCase (new WifiAntennaBatchGainTestCase ("ns3::WifiCosineAntennaModel", 0, table), TestCase::QUICK);
+      AddTestCase (new WifiAntennaBatchGainTestCase ("ns3::WifiParabolicAntennaModel", 0, table), TestCase::QUICK);
+      AddTestCase (new WifiAntennaBatchGainTestCase ("ns3::WifiConstantGainAntennaModel", 0, table), TestCase::QUICK);
+      AddTestCase (new WifiAntennaBatchGainTestCase ("ns3::WifiSwitchedBeamAntennaModel", 4, table), TestCase::QUICK);
+      AddTestCase (new WifiAntennaBatchGainTestCase ("ns3::WifiSwitchedBeamAntennaModel", 16, table), TestCase::QUICK);
+    }
+}
+
+static WifiAntennaBatchGainTestSuite staticWifiAntennaBatchGainTestSuiteInstance;
@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/boolean.h>
+#include <ns3/enum.h>
+#include <ns3/object-factory.h>
+#include <ns3/wifi-antenna-model.h>
+#include <ns3/mobility-module.h>
+#include <ns3/simulator.h>
+#include <cmath>
+#include <string>
+#include <sstream>
+#include "wifi-antenna-test-fixture.h"
+
+
+NS_LOG_COMPONENT_DEFINE ("TestWifiAntennaGainTable");
+
+using namespace ns3;
+
+/**
+ * Compare the gains served from the gain table with those of the
+ * analytic pattern, in every mode, for directions all around the
+ * antenna.
+ */
+class WifiAntennaGainTableTestCase : public TestCase
+{
+public:
+  static std::string BuildNameString (std::string type, WifiAntennaModel::GainTableInterpolation interpolation);
+  WifiAntennaGainTableTestCase (std::string type, WifiAntennaModel::GainTableInterpolation interpolation,
+                                double tolerance, double floorDb, bool skipSectorEdges);
+
+private:
+  virtual void DoRun (void);
+
+  std::string m_type;
+  WifiAntennaModel::GainTableInterpolation m_interpolation;
+  double m_tolerance;
+  double m_floorDb;
+  bool m_skipSectorEdges;
+};
+
+std::string
+WifiAntennaGainTableTestCase::BuildNameString (std::string type, WifiAntennaModel::GainTableInterpolation interpolation)
+{
+  std::ostringstream oss;
+  oss << type << ", interpolation="
+      << (interpolation == WifiAntennaModel::GAIN_TABLE_NEAREST ? "nearest" : "linear");
+  return oss.str ();
+}
+
+WifiAntennaGainTableTestCase::WifiAntennaGainTableTestCase (std::string type,
+                                                            WifiAntennaModel::GainTableInterpolation interpolation,
+                                                            double tolerance, double floorDb, bool skipSectorEdges)
+  : TestCase (BuildNameString (type, interpolation)),
+    m_type (type),
+    m_interpolation (interpolation),
+    m_tolerance (tolerance),
+    m_floorDb (floorDb),
+    m_skipSectorEdges (skipSectorEdges)
+{
+}
+
+void
+WifiAntennaGainTableTestCase::DoRun ()
+{
+  NS_LOG_FUNCTION (this << BuildNameString (m_type, m_interpolation));
+
+  ObjectFactory factory;
+  factory.SetTypeId (m_type);
+  Ptr<WifiAntennaModel> analytic = factory.Create<WifiAntennaModel> ();
+  Ptr<WifiAntennaModel> tabulated = factory.Create<WifiAntennaModel> ();
+  tabulated->SetAttribute ("UseGainTable", BooleanValue (true));
+  tabulated->SetAttribute ("GainTableInterpolation", EnumValue (m_interpolation));
+
+  Ptr<ConstantPositionMobilityModel> src = CreateObject<ConstantPositionMobilityModel> ();
+  src->SetPosition (Vector (0, 0, 0));
+  Ptr<ConstantPositionMobilityModel> dest = CreateObject<ConstantPositionMobilityModel> ();
+
+  double expected[WifiAntennaModel::MAX_ANTENNA_MODES];
+  double actual[WifiAntennaModel::MAX_ANTENNA_MODES];
+  int nModes = analytic->GetNAntennaModes ();
+  double heights[] = { 0.0, 40.0, -25.0 };
+  uint32_t nHeights = m_skipSectorEdges ? 1 : 3;
+  for (uint32_t h = 0; h < nHeights; h++)
+    {
+      // a step which is not a divisor of 45 degrees, so that the
+      // directions do not line up with the samples of the table
+      for (double phiDeg = -179.3; phiDeg < 180; phiDeg += 2.3)
+        {
+          double edge = std::fmod (phiDeg + 360.0, 45.0);
+          if (m_skipSectorEdges && (edge < 1.0 || edge > 44.0))
+            {
+              continue;
+            }
+          double phi = phiDeg * M_PI / 180.0;
+          dest->SetPosition (Vector (100 * std::cos (phi), 100 * std::sin (phi), heights[h]));
+          analytic->GetGainsDb (src, dest, expected);
+          tabulated->GetGainsDb (src, dest, actual);
+          for (int mode = 0; mode < nModes; mode++)
+            {
+              if (expected[mode] < m_floorDb)
+                {
+                  NS_TEST_EXPECT_MSG_LT (actual[mode], m_floorDb + m_tolerance,
+                                         "gain above the floor at phi=" << phiDeg << " mode=" << mode);
+                  continue;
+                }
+              NS_TEST_EXPECT_MSG_EQ_TOL (actual[mode], expected[mode], m_tolerance,
+                                         "wrong tabulated gain at phi=" << phiDeg << " mode=" << mode);
+            }
+        }
+    }
+}
+
+/**
+ * Check that switched-beam antennas first queried in different modes
+ * share one gain table, and that Simulator::Destroy releases it.
+ */
+class WifiAntennaGainTableRegistryTestCase : public TestCase
+{
+public:
+  WifiAntennaGainTableRegistryTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WifiAntennaGainTableRegistryTestCase::WifiAntennaGainTableRegistryTestCase ()
+  : TestCase ("gain tables are shared across modes and released on destroy")
+{
+}
+
+void
+WifiAntennaGainTableRegistryTestCase::DoRun ()
+{
+  WifiAntennaGainTableRegistry::Clear ();
+
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::WifiSwitchedBeamAntennaModel");
+  factory.Set ("UseGainTable", BooleanValue (true));
+  Ptr<WifiAntennaModel> omni = CreateWifiTestAntenna (factory);
+  Ptr<WifiAntennaModel> directional = CreateWifiTestAntenna (factory);
+  directional->SetAntennaMode (2);
+
+  Angles direction (0.3, 0.0);
+  omni->GetGainDb (direction);
+  directional->GetGainDb (direction);
+  NS_TEST_EXPECT_MSG_EQ (WifiAntennaGainTableRegistry::GetN (), 1u,
+                         "the mode of the first query should not split the gain table");
+
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (WifiAntennaGainTableRegistry::GetN (), 0u,
+                         "Simulator::Destroy should release the gain tables");
+}
+
+
+
+class WifiAntennaGainTableTestSuite : public TestSuite
+{
+public:
+  WifiAntennaGainTableTestSuite ();
+};
+
+WifiAntennaGainTableTestSuite::WifiAntennaGainTableTestSuite ()
+  : TestSuite ("wifi-antenna-gain-table", UNIT)
+{
+  // with the default 1 degree resolution, linear interpolation of the
+  // smooth patterns is within a few thousandths of a dB down to -30 dB
+  AddTestCase (new WifiAntennaGainTableTestCase ("ns3::WifiCosineAntennaModel",
+                                                 WifiAntennaModel::GAIN_TABLE_LINEAR, 0.01, -30, false), TestCase::QUICK);
+  AddTestCase (new WifiAntennaGainTableTestCase ("ns3::WifiParabolicAntennaModel",
+                                                 WifiAntennaModel::GAIN_TABLE_LINEAR, 0.01, -30, false), TestCase::QUICK);
+  AddTestCase (new WifiAntennaGainTableTestCase ("ns3::WifiIsotropicAntennaModel",
+                                                 WifiAntennaModel::GAIN_TABLE_LINEAR, 1e-6, -300, false), TestCase::QUICK);
+  // piecewise constant patterns are exact with the nearest sample,
+  // away from the edges of the sectors
+  AddTestCase (new WifiAntennaGainTableTestCase ("ns3::WifiSwitchedBeamAntennaModel",
+                                                 WifiAntennaModel::GAIN_TABLE_NEAREST, 1e-6, -300, true), TestCase::QUICK);
+  AddTestCase (new WifiAntennaGainTableRegistryTestCase, TestCase::QUICK);
+}
+
+static WifiAntennaGainTableTestSuite staticWifiAntennaGainTableTestSuiteInstance;
@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/constant-orientation-model.h>
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/uinteger.h>
+#include <ns3/wifi-switched-beam-antenna-model.h>
+#include <cmath>
+#include <sstream>
+
+
+NS_LOG_COMPONENT_DEFINE ("TestWifiSwitchedBeamSector");
+
+using namespace ns3;
+
+/**
+ * Check that the sector picked from a displacement vector is the one
+ * picked from the Angles of the same direction, including directions
+ * on the sector boundaries and along the axes.
+ */
+class WifiSwitchedBeamSectorTestCase : public TestCase
+{
+public:
+  WifiSwitchedBeamSectorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WifiSwitchedBeamSectorTestCase::WifiSwitchedBeamSectorTestCase ()
+  : TestCase ("vector and Angles sector selection agree")
+{
+}
+
+void
+WifiSwitchedBeamSectorTestCase::DoRun ()
+{
+  Ptr<WifiSwitchedBeamAntennaModel> antenna = CreateObject<WifiSwitchedBeamAntennaModel> ();
+  // SetAntennaMode steers the beam through the orientation model
+  antenna->SetOrientationModel (CreateObject<ConstantOrientationModel> ());
+  NS_TEST_EXPECT_MSG_EQ (antenna->GetNAntennaModes (), 5u, "wrong default number of modes");
+
+  Vector axes[] = { Vector (1, 0, 0), Vector (0, 1, 0), Vector (-1, 0, 0), Vector (0, -1, 0) };
+  int modes[] = { WifiSwitchedBeamAntennaModel::DIRECTIONAL0, WifiSwitchedBeamAntennaModel::DIRECTIONAL90,
+                  WifiSwitchedBeamAntennaModel::DIRECTIONAL180, WifiSwitchedBeamAntennaModel::DIRECTIONAL270 };
+  for (int i = 0; i < 4; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (antenna->GetNextAntennaMode (axes[i]), modes[i],
+                             "wrong sector along axis " << axes[i]);
+      NS_TEST_EXPECT_MSG_EQ (antenna->GetNextAntennaMode (axes[i]),
+                             antenna->GetNextAntennaMode (Angles (axes[i])),
+                             "vector and Angles disagree along axis " << axes[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (antenna->GetNextAntennaMode (Vector (0, 0, 10)),
+                         WifiSwitchedBeamAntennaModel::DIRECTIONAL0,
+                         "a vertical direction should fall in the first sector");
+
+  for (double phiDeg = -179.3; phiDeg < 180; phiDeg += 2.3)
+    {
+      double phi = phiDeg * M_PI / 180.0;
+      Vector direction (100 * std::cos (phi), 100 * std::sin (phi), 20);
+      NS_TEST_EXPECT_MSG_EQ (antenna->GetNextAntennaMode (direction),
+                             antenna->GetNextAntennaMode (Angles (direction)),
+                             "vector and Angles disagree at phi=" << phiDeg);
+    }
+
+  antenna->SetAntennaMode (Vector (-3, -4, 0));
+  NS_TEST_EXPECT_MSG_EQ (antenna->GetAntennaMode (), WifiSwitchedBeamAntennaModel::DIRECTIONAL180,
+                         "SetAntennaMode did not switch to the sector of the direction");
+}
+
+/**
+ * With N sectors, check that both selection paths agree and pick the
+ * sector whose share of the azimuth contains the direction.
+ */
+class WifiSwitchedBeamNSectorsTestCase : public TestCase
+{
+public:
+  static std::string BuildNameString (uint32_t nSectors);
+  WifiSwitchedBeamNSectorsTestCase (uint32_t nSectors);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_nSectors;
+};
+
+std::string
+WifiSwitchedBeamNSectorsTestCase::BuildNameString (uint32_t nSectors)
+{
+  std::ostringstream oss;
+  oss << "sectors=" << nSectors;
+  return oss.str ();
+}
+
+WifiSwitchedBeamNSectorsTestCase::WifiSwitchedBeamNSectorsTestCase (uint32_t nSectors)
+  : TestCase (BuildNameString (nSectors)),
+    m_nSectors (nSectors)
+{
+}
+
+void
+WifiSwitchedBeamNSectorsTestCase::DoRun ()
+{
+  Ptr<WifiSwitchedBeamAntennaModel> antenna = CreateObject<WifiSwitchedBeamAntennaModel> ();
+  antenna->SetAttribute ("Sectors", UintegerValue (m_nSectors));
+  NS_TEST_ASSERT_MSG_EQ (antenna->GetNAntennaModes (), m_nSectors + 1, "wrong number of modes");
+
+  double width = 360.0 / m_nSectors;
+  for (double phiDeg = 0.7; phiDeg < 360; phiDeg += 2.3)
+    {
+      double edge = std::fmod (phiDeg, width);
+      if (edge < 0.5 || edge > width - 0.5)
+        {
+          continue;
+        }
+      double phi = phiDeg * M_PI / 180.0;
+      Vector direction (std::cos (phi), std::sin (phi), 0);
+      int mode = antenna->GetNextAntennaMode (direction);
+      NS_TEST_EXPECT_MSG_EQ (mode, antenna->GetNextAntennaMode (Angles (direction)),
+                             "vector and Angles disagree at phi=" << phiDeg);
+      NS_TEST_EXPECT_MSG_EQ (mode, 1 + static_cast<int> (phiDeg / width),
+                             "wrong sector at phi=" << phiDeg);
+    }
+}
+
+
+class WifiSwitchedBeamSectorTestSuite : public TestSuite
+{
+public:
+  WifiSwitchedBeamSectorTestSuite ();
+};
+
+WifiSwitchedBeamSectorTestSuite::WifiSwitchedBeamSectorTestSuite ()
+  : TestSuite ("wifi-switched-beam-sector", UNIT)
+{
+  AddTestCase (new WifiSwitchedBeamSectorTestCase, TestCase::QUICK);
+  AddTestCase (new WifiSwitchedBeamNSectorsTestCase (1), TestCase::QUICK);
+  AddTestCase (new WifiSwitchedBeamNSectorsTestCase (8), TestCase::QUICK);
+  AddTestCase (new WifiSwitchedBeamNSectorsTestCase (16), TestCase::QUICK);
+}
+
+static WifiSwitchedBeamSectorTestSuite staticWifiSwitchedBeamSectorTestSuiteInstance;
@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef WIFI_ANTENNA_TEST_FIXTURE_H
+#define WIFI_ANTENNA_TEST_FIXTURE_H
+
+#include <ns3/object-factory.h>
+#include <ns3/vector.h>
+#include <ns3/constant-orientation-model.h>
+#include <ns3/wifi-antenna-model.h>
+#include <cmath>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \return an antenna of the factory's type with a constant orientation
+ * model, which the antenna needs as soon as it switches modes
+ */
+inline Ptr<WifiAntennaModel>
+CreateWifiTestAntenna (const ObjectFactory &factory)
+{
+  Ptr<WifiAntennaModel> antenna = factory.Create<WifiAntennaModel> ();
+  antenna->SetOrientationModel (CreateObject<ConstantOrientationModel> ());
+  return antenna;
+}
+
+/**
+ * A receiver of the sweep around GetWifiTestSource.
+ */
+struct WifiTestReceiver
+{
+  Vector position;
+  double phiDeg; //!< azimuth of the receiver seen from the source
+};
+
+/**
+ * \return the transmitter of the sweep, away from the origin so that
+ * directions are not computed from the receiver position alone
+ */
+inline Vector
+GetWifiTestSource (void)
+{
+  return Vector (10, -20, 1.5);
+}
+
+/**
+ * \return receivers 80 m around the source every 7.3 degrees, a step
+ * which does not line up with sector edges, at the height of the
+ * source, above it and below it
+ */
+inline std::vector<WifiTestReceiver>
+GetWifiTestReceivers (void)
+{
+  Vector src = GetWifiTestSource ();
+  double heights[] = { 1.5, 30.0, -12.0 };
+  std::vector<WifiTestReceiver> receivers;
+  for (uint32_t h = 0; h < 3; h++)
+    {
+      for (double phiDeg = -178.1; phiDeg < 180; phiDeg += 7.3)
+        {
+          double phi = phiDeg * M_PI / 180.0;
+          WifiTestReceiver r;
+          r.position = Vector (src.x + 80 * std::cos (phi), src.y + 80 * std::sin (phi), heights[h]);
+          r.phiDeg = phiDeg;
+          receivers.push_back (r);
+        }
+    }
+  return receivers;
+}
+
+} // namespace ns3
+
+#endif /* WIFI_ANTENNA_TEST_FIXTURE_H */